@@ -0,0 +1,40 @@
+// analog_matrix.c - double-buffered analog frames from the scanner
+// The scanner (core1, or core0 inline) fills the back buffer and flips it by
+// bumping seq; readers on core0 copy the front buffer and retry if seq moved.
+#include "analog_matrix.h"
+#include "hardware/sync.h"
+#include <string.h>
+
+static analog_frame_t frames[2];
+static volatile uint32_t published_seq = 0;
+
+analog_frame_t *analog_matrix_back_buffer(void) {
+    return &frames[(published_seq + 1) & 1];
+}
+
+void analog_matrix_publish(void) {
+    uint32_t seq = published_seq + 1;
+    frames[seq & 1].seq = seq;
+    __dmb();
+    published_seq = seq;
+}
+
+bool analog_matrix_read(analog_frame_t *frame) {
+    uint32_t seq;
+    do {
+        seq = published_seq;
+        __dmb();
+        memcpy(frame, &frames[seq & 1], sizeof(*frame));
+        __dmb();
+    } while (seq != published_seq);
+    return seq != 0;
+}
+
+uint16_t analog_matrix_travel(uint8_t row, uint8_t col) {
+    if (row >= MATRIX_ROWS || col >= MATRIX_COLS) return 0;
+    return frames[published_seq & 1].travel[row * MATRIX_COLS + col];
+}
+
+uint32_t analog_matrix_seq(void) {
+    return published_seq;
+}
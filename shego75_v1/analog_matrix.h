@@ -0,0 +1,38 @@
+/* analog_matrix.h - per-key analog travel published by the scanner */
+#pragma once
+
+#include QMK_KEYBOARD_H
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ANALOG_MATRIX_KEYS (MATRIX_ROWS * MATRIX_COLS)
+
+// Travel is fixed point: 0 = at rest, ANALOG_TRAVEL_FULL = bottomed out,
+// normalized per key from its calibrated rest and bottom-out values and
+// linearized through its hall curve (travel_lut.h), so it is proportional to
+// physical depth (ANALOG_TRAVEL_FULL = KEY_TRAVEL_MM_X100)
+#define ANALOG_TRAVEL_SHIFT 10
+#define ANALOG_TRAVEL_FULL  (1 << ANALOG_TRAVEL_SHIFT)
+
+// One scan pass. Keys are indexed row * MATRIX_COLS + col; unwired
+// positions stay at 0.
+typedef struct {
+    uint32_t seq;                         // pass number, increments per publish
+    uint32_t time_us;                     // when the pass was evaluated
+    matrix_row_t pressed[MATRIX_ROWS];    // key state after evaluation
+    uint16_t travel[ANALOG_MATRIX_KEYS];  // 0..ANALOG_TRAVEL_FULL
+} analog_frame_t;
+
+// Copy the latest published pass (consistent: retried if the scanner
+// publishes meanwhile). Returns false until the first pass is published.
+bool analog_matrix_read(analog_frame_t *frame);
+
+// Travel of a single key from the latest pass
+uint16_t analog_matrix_travel(uint8_t row, uint8_t col);
+
+// Number of passes published so far (cheap "is there a new frame" check)
+uint32_t analog_matrix_seq(void);
+
+// Scanner side (mux_adc.c): fill the back buffer, then publish it
+analog_frame_t *analog_matrix_back_buffer(void);
+void analog_matrix_publish(void);
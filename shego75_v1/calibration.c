@@ -0,0 +1,83 @@
+// calibration.c - versioned, CRC-checked calibration record in the
+// keyboard EEPROM datablock (wear-leveled flash on the RP2040)
+#include "calibration.h"
+#include "mux_pins.h"
+#include "eeconfig.h"
+#include <stddef.h>
+#include <string.h>
+
+// Bump CALIBRATION_VERSION whenever calibration_data_t changes shape or meaning
+#define CALIBRATION_MAGIC   0x43414C00u  // "CAL"
+#define CALIBRATION_VERSION 7
+
+typedef struct {
+    uint32_t magic_version;  // CALIBRATION_MAGIC | CALIBRATION_VERSION
+    uint32_t layout_hash;    // matrix size + mux wiring the data belongs to
+    calibration_data_t data;
+    uint16_t crc;            // CRC-16/CCITT over everything above
+} calibration_record_t;
+
+// eeconfig reads and writes the whole datablock, so work on a full-size copy
+typedef union {
+    calibration_record_t record;
+    uint8_t raw[EECONFIG_KB_DATA_SIZE];
+} calibration_block_t;
+
+_Static_assert(sizeof(calibration_record_t) <= EECONFIG_KB_DATA_SIZE, "raise EECONFIG_KB_DATA_SIZE in config.h");
+
+static calibration_block_t block;
+
+static uint16_t crc16_ccitt(const uint8_t *data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    while (len--) {
+        crc ^= (uint16_t)*data++ << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static uint32_t fnv1a_byte(uint32_t hash, uint8_t byte) {
+    return (hash ^ byte) * 16777619u;
+}
+
+// Hash of everything that decides which sensor a stored value belongs to:
+// the matrix shape and every scan plan entry (so editing MUX_WIRING
+// invalidates old records).
+static uint32_t layout_hash(void) {
+    uint32_t hash = 2166136261u;
+    hash = fnv1a_byte(hash, MATRIX_ROWS);
+    hash = fnv1a_byte(hash, MATRIX_COLS);
+    hash = fnv1a_byte(hash, SCAN_PLAN_LEN);
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        hash = fnv1a_byte(hash, scan_plan[i].channel);
+        hash = fnv1a_byte(hash, scan_plan[i].mux);
+        hash = fnv1a_byte(hash, scan_plan[i].key_idx);
+    }
+    return hash;
+}
+
+bool calibration_load(calibration_data_t *data) {
+    const calibration_record_t *rec = &block.record;
+
+    eeconfig_read_kb_datablock(block.raw);
+    if (rec->magic_version != (CALIBRATION_MAGIC | CALIBRATION_VERSION)) return false;
+    if (rec->layout_hash != layout_hash()) return false;
+    if (rec->crc != crc16_ccitt(block.raw, offsetof(calibration_record_t, crc))) return false;
+
+    memcpy(data, &rec->data, sizeof(*data));
+    return true;
+}
+
+void calibration_save(const calibration_data_t *data) {
+    calibration_record_t *rec = &block.record;
+
+    memset(block.raw, 0, sizeof(block.raw));
+    rec->magic_version = CALIBRATION_MAGIC | CALIBRATION_VERSION;
+    rec->layout_hash = layout_hash();
+    memcpy(&rec->data, data, sizeof(rec->data));
+    rec->crc = crc16_ccitt(block.raw, offsetof(calibration_record_t, crc));
+
+    eeconfig_update_kb_datablock(block.raw);
+}
@@ -0,0 +1,37 @@
+/* calibration.h - per-key sensor calibration persisted in EEPROM */
+#pragma once
+
+#include QMK_KEYBOARD_H
+#include "mux_adc.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CALIBRATION_KEYS (MATRIX_ROWS * MATRIX_COLS)
+
+// Per-key values kept across power cycles; bands are rebuilt from these
+typedef struct {
+    uint16_t baseline[CALIBRATION_KEYS];
+    uint8_t sensitivity_percent[CALIBRATION_KEYS];
+    uint16_t bottom_out[CALIBRATION_KEYS];  // travel at bottom-out, ADC counts
+    uint16_t actuation_mm_x100[CALIBRATION_KEYS];
+    uint16_t reset_mm_x100[CALIBRATION_KEYS];
+    int8_t polarity[CALIBRATION_KEYS];      // 1 = up, -1 = down, 0 = unknown
+    uint16_t noise_x16[CALIBRATION_KEYS];   // resting noise sigma, ADC counts x16
+    uint8_t sensitivity_sigma[CALIBRATION_KEYS];
+    // Crosstalk each key causes: neighbour key index and Q12 coefficient
+    uint8_t crosstalk_target[CALIBRATION_KEYS][CROSSTALK_NEIGHBORS];
+    int16_t crosstalk_coef[CALIBRATION_KEYS][CROSSTALK_NEIGHBORS];
+    // Resting-value slope per key (ADC counts per degC, Q8) and the
+    // temperature the baselines above belong to (0.01 degC)
+    int16_t temp_coef_q8[CALIBRATION_KEYS];
+    int16_t temp_ref_x100;
+} calibration_data_t;
+
+// Load the stored calibration. Returns false if there is none, it is
+// corrupt, it has another record version, or it was taken with a different
+// matrix size or mux wiring.
+bool calibration_load(calibration_data_t *data);
+
+// Store calibration in the keyboard EEPROM datablock (wear-leveled flash;
+// the backing-store write parks core1, see core1.c).
+void calibration_save(const calibration_data_t *data);
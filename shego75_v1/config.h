@@ -8,11 +8,35 @@
 // ============================================================================
 // AUTO-CALIBRATION CONFIGURATION
 // ============================================================================
-// The keyboard automatically calibrates sensor thresholds on startup.
-// Each key's baseline (resting) value is measured, and actuation occurs when
-// the ADC drops below CALIBRATION_THRESHOLD_PERCENT of that baseline.
+// The keyboard calibrates sensor thresholds once and keeps the result in
+// EEPROM (calibration.c). Each key's baseline (resting) value is measured, and
+// actuation occurs when the ADC drops below CALIBRATION_THRESHOLD_PERCENT of
+// that baseline. Later boots load the stored record instantly; it is measured
+// again only when missing, after an EEPROM clear, when the mux wiring changes,
+// or on request (raw HID 0x22). Raw HID 0x23 captures each key's bottom-out
+// travel (start, press every key fully, stop) for the analog travel API.
 //
-// IMPORTANT: Ensure NO KEYS ARE PRESSED during power-on!
+// Calibration also measures each key's resting noise. Sensitivity can then
+// be set per key in multiples of it (raw HID 0x25), so quiet keys actuate
+// earlier than the noisiest one allows; raw HID 0x26 reads the noise map.
+//
+// Raw HID 0x2B measures magnetic crosstalk (start, hold each key down alone
+// for a moment, stop): every key's leak into up to CROSSTALK_NEIGHBORS keys
+// is stored with the calibration and subtracted from their samples, so
+// actuation points can sit closer to rest without neighbours firing.
+// #define CROSSTALK_COMPENSATION 1
+// #define CROSSTALK_NEIGHBORS 3
+//
+// Temperature compensation: the RP2040's internal sensor is read every few
+// seconds and each key's baseline follows its learned slope. Learn the
+// slopes once with raw HID 0x2D (start cold with hands off, let the board
+// warm up with the LEDs on, stop); 0x2E reads the temperature and progress.
+// Needs the parallel scan (MUX_SCAN_PARALLEL), which sets up the ADC.
+// #define TEMP_COMPENSATION 0
+// #define TEMP_SENSITIVITY_PPM_PER_C -1000
+// #define CALIBRATION_SAMPLES 16
+//
+// IMPORTANT: Ensure NO KEYS ARE PRESSED while calibration is measured!
 //
 // Adjusting sensitivity:
 // - Lower percentage (e.g., 80) = MORE sensitive (earlier actuation, lighter touch)
@@ -22,6 +46,111 @@
 // #define CALIBRATION_THRESHOLD_PERCENT 85
 //
 // Default is 85% (15% drop from baseline triggers actuation)
+//
+// Keyboard EEPROM datablock holding the calibration record
+#define EECONFIG_KB_DATA_SIZE 2560
+// ============================================================================
+
+// ============================================================================
+// MUX SCAN CONFIGURATION
+// ============================================================================
+// By default all three ADG732s are latched to the same address at once and
+// GP26/GP27/GP28 are sampled back to back (ADC round-robin), so one pass pays
+// 32 settle waits instead of 96. Set to 0 to fall back to the serial scan.
+// #define MUX_SCAN_PARALLEL 0
+//
+// Once calibration finishes, scanning moves to core1 and runs continuously;
+// matrix_scan_custom just copies the latest pass. Set to 0 to scan inline on
+// core0 (required if MUX_SCAN_PARALLEL is 0).
+// #define MUX_SCAN_CORE1 0
+//
+// core1 passes run back to back; set a period to start each pass on a
+// hardware alarm at a fixed rate instead. Key changes reach QMK through a
+// timestamped queue either way, so no transition is lost between polls.
+// #define MUX_SCAN_PERIOD_US 1000
+//
+// Predictive actuation: press when a key's tracked velocity puts it past the
+// actuation point before its next sample (static actuation only). The lead
+// is in percent of a sample interval and can be changed over raw HID (0x2A);
+// predicted and false presses per second show up in the scan stats (0x29).
+// #define KEY_PREDICTIVE_ACTUATION 1
+// #define PREDICT_LEAD_PERCENT 100
+// #define PREDICT_MIN_SPEED 8
+//
+// Adaptive oversampling: addresses with a key close to its actuation or
+// release point are converted MUX_OVERSAMPLE_COUNT times and averaged, the
+// rest once. Oversampled samples per second are in the scan stats (0x29),
+// per key over raw HID 0x2C. Not with the PIO engine.
+// #define MUX_SCAN_OVERSAMPLE 1
+// #define MUX_OVERSAMPLE_COUNT 4
+//
+// ADC codes 512/1536/2560/3584 (12-bit) are wider than the rest on the
+// RP2040; every conversion is corrected for that (ADC_DNL_EXTRA_LSB wide).
+// A random 0..MUX_SETTLE_DITHER_US extra settle per address dithers the
+// sampling instant so averaged readings do not stick to single codes.
+// #define ADC_DNL_CORRECTION 0
+// #define ADC_DNL_EXTRA_LSB 8
+// #define MUX_SETTLE_DITHER_US 4
+//
+// Settle time after each address change (defaults to 100us, see mux_adc.h)
+// #define MUX_SETTLE_US 100
+//
+// With the parallel CPU scan, each address's settle time is measured at boot
+// (MUX_SETTLE_US becomes the upper limit) and the pass total is printed on
+// the debug UART. Set to 0 to always wait MUX_SETTLE_US.
+// #define MUX_SETTLE_ADAPTIVE 0
+// #define MUX_SETTLE_MARGIN_US 10
+//
+// The parallel CPU scan also reorders its addresses at boot so neighbours in
+// the sequence have similar resting levels. Set to 0 to keep MUX_WIRING order.
+// #define MUX_SCAN_ORDER_OPTIMIZE 0
+//
+// Priority scheduling: keys in SCAN_HOT_KEYS are sampled every pass and the
+// other addresses SCAN_COLD_SLICE per pass in rotation. Hot keys get a
+// shorter pass; cold keys are at most ceil(cold addresses / slice) passes
+// old. Priorities can be changed over raw HID (0x27), not stored.
+// #define MUX_SCAN_PRIORITY 1
+// #define SCAN_COLD_SLICE 4
+// #define SCAN_HOT_KEYS K_W, K_A, K_S, K_D, K_SPACE, K_LSHIFT, K_LCTRL
+//
+// Without core1, each pass is timed to end this long before the next USB
+// start-of-frame, so every report carries a sample from the same frame.
+// #define SCAN_GOVERNOR_GUARD_US 50
+//
+// Free-running PIO + DMA scan engine: no CPU time in the scan at all. The
+// full-board rate is set by MUX_PIO_SETTLE_US (0 -> ~4.1 kHz, 10 -> ~1.8 kHz);
+// 4 kHz and up needs 0.
+// #define MUX_SCAN_PIO 1
+// #define MUX_PIO_SETTLE_US 10
+//
+// Key state uses hysteresis instead of a debounce timer: a key releases once
+// it is back within KEY_RELEASE_PERCENT of its press deviation, and changes
+// state after KEY_CONFIRM_SAMPLES agreeing samples (see mux_adc.h).
+// #define KEY_RELEASE_PERCENT 50
+// #define KEY_CONFIRM_SAMPLES 2
+//
+// Resting values are re-tracked in the background so thermal drift does
+// not creep into the bands. Set to 0 to keep the boot calibration fixed.
+// #define BASELINE_DRIFT_TRACKING 0
+// #define BASELINE_DRIFT_MAX 40
+//
+// Samples can pass a median-of-3 per key so one-pass crosstalk spikes are
+// dropped, at a pass of latency on every press. Set to 1 on noisy boards.
+// #define SPIKE_FILTER 1
+//
+// Rapid trigger for every key at boot (per key over raw HID 0x21).
+// Deltas are in 0.01 mm of linearized travel.
+// #define RAPID_TRIGGER_DEFAULT_MODE RAPID_TRIGGER_CONTINUOUS
+// #define RAPID_TRIGGER_PRESS_MM_X100 15
+// #define RAPID_TRIGGER_RELEASE_MM_X100 15
+//
+// Travel is linearized per key (travel_lut.c) from its rest and captured
+// bottom-out, so actuation can be given in millimetres (0.01 mm units, per
+// key over raw HID 0x24). 0 keeps the sensitivity percent.
+// #define KEY_TRAVEL_MM_X100 400
+// #define KEY_MAGNET_GAP_MM_X100 150
+// #define KEY_ACTUATION_MM_X100 120
+// #define KEY_RESET_MM_X100 80
 // ============================================================================
 
 // ============================================================================
@@ -0,0 +1,121 @@
+// core1.c - start a loop on the RP2040's second core
+// Uses the bootrom SIO FIFO handshake (same sequence as pico-sdk's
+// multicore_launch_core1_raw) so we don't need pico_multicore in the build.
+#include "core1.h"
+
+#include <stddef.h>
+#include "hardware/structs/sio.h"
+#include "hardware/structs/scb.h"
+#include "hardware/sync.h"
+#include "pico/platform.h"
+
+#ifndef CORE1_STACK_WORDS
+#define CORE1_STACK_WORDS 1024  // 4 KB
+#endif
+
+static uint32_t core1_stack[CORE1_STACK_WORDS] __attribute__((aligned(8)));
+static bool core1_started = false;
+static volatile bool park_requested = false;
+static volatile bool parked = false;
+static uint8_t park_depth = 0;  // core0 only
+
+static void fifo_drain(void) {
+    while (sio_hw->fifo_st & SIO_FIFO_ST_VLD_BITS) {
+        (void)sio_hw->fifo_rd;
+    }
+}
+
+static void fifo_push(uint32_t value) {
+    while (!(sio_hw->fifo_st & SIO_FIFO_ST_RDY_BITS)) {
+    }
+    sio_hw->fifo_wr = value;
+    __sev();  // core1 sleeps in the bootrom with WFE
+}
+
+static uint32_t fifo_pop(void) {
+    while (!(sio_hw->fifo_st & SIO_FIFO_ST_VLD_BITS)) {
+        __wfe();
+    }
+    return sio_hw->fifo_rd;
+}
+
+void core1_launch(void (*entry)(void)) {
+    if (core1_started || !entry) return;
+
+    // Bootrom protocol: 0, 0, 1, vector table, stack pointer, entry.
+    // Each word is echoed back; any mismatch restarts the sequence.
+    const uint32_t cmd_sequence[] = {
+        0, 0, 1,
+        scb_hw->vtor,
+        (uint32_t)(uintptr_t)&core1_stack[CORE1_STACK_WORDS],
+        (uint32_t)(uintptr_t)entry,
+    };
+
+    size_t seq = 0;
+    do {
+        uint32_t cmd = cmd_sequence[seq];
+        if (!cmd) {
+            fifo_drain();
+            __sev();
+        }
+        fifo_push(cmd);
+        uint32_t response = fifo_pop();
+        seq = (cmd == response) ? seq + 1 : 0;
+    } while (seq < sizeof(cmd_sequence) / sizeof(cmd_sequence[0]));
+
+    core1_started = true;
+}
+
+bool core1_running(void) {
+    return core1_started;
+}
+
+// Runs from RAM and touches only RAM while core0 owns the flash
+static void __not_in_flash_func(core1_park_loop)(void) {
+    parked = true;
+    __dmb();
+    while (park_requested) {
+    }
+    __dmb();
+    parked = false;
+}
+
+void core1_park_point(void) {
+    if (park_requested) {
+        core1_park_loop();
+    }
+}
+
+void core1_park_begin(void) {
+    if (!core1_started || park_depth++) return;
+    park_requested = true;
+    __dmb();
+    while (!parked) {
+    }
+}
+
+void core1_park_end(void) {
+    if (!core1_started || !park_depth || --park_depth) return;
+    park_requested = false;
+    __dmb();
+    while (parked) {
+    }
+}
+
+// Every wear-leveled EEPROM write (eeconfig, VIA, dynamic keymap, our
+// calibration record, compaction erases) runs between backing_store_unlock()
+// and backing_store_lock(). The RP2040 driver has no hook there, so rules.mk
+// wraps both at link time and core1 sits parked in RAM for the duration.
+bool __real_backing_store_unlock(void);
+bool __real_backing_store_lock(void);
+
+bool __wrap_backing_store_unlock(void) {
+    core1_park_begin();
+    return __real_backing_store_unlock();
+}
+
+bool __wrap_backing_store_lock(void) {
+    bool ok = __real_backing_store_lock();
+    core1_park_end();
+    return ok;
+}
@@ -0,0 +1,24 @@
+/* core1.h - launch a bare-metal loop on the RP2040's second core */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Start entry() on core1 with its own stack. The entry must never return.
+// ChibiOS only runs on core0, so code on core1 must not call into the RTOS
+// (no timer_read32, wait_ms, analogReadPin, uart/print) - raw hardware only.
+void core1_launch(void (*entry)(void));
+
+// True once core1_launch() has handed core1 its entry point
+bool core1_running(void);
+
+// Flash erase/program stalls XIP, so core1 must not run from flash meanwhile.
+// core1_park_begin() (core0) waits until core1 spins in a RAM-resident loop;
+// core1_park_end() lets it continue. The core1 loop must call
+// core1_park_point() regularly (between scan passes, so the scanner also
+// parks while core0 changes its configuration). Begin/end pairs nest; both
+// are no-ops before core1_launch(). Wear-leveled EEPROM writes park core1
+// on their own (see core1.c), so any eeconfig/VIA write is safe.
+void core1_park_begin(void);
+void core1_park_end(void);
+void core1_park_point(void);
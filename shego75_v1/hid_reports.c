@@ -6,6 +6,7 @@
 #include "uart_keycodes.h" // for toggle_led() prototype
 #include "raw_hid.h"
 #include "mux_adc.h"
+#include "key_events.h"
 #include "vendor_bridge.h"
 #include <string.h>
 #include <stdio.h>
@@ -28,6 +29,17 @@ void hid_reports_init(void) {
 }
 
 // Send status back to host
+// Send one RAW_EPSIZE report, preferring the vendor endpoint if available
+static void send_report_to_host(uint8_t *report) {
+#ifdef VENDOR_ENABLE
+    if (!vendor_send_response(report, RAW_EPSIZE)) {
+        raw_hid_send(report, RAW_EPSIZE);
+    }
+#else
+    raw_hid_send(report, RAW_EPSIZE);
+#endif
+}
+
 void send_status_to_host(uint8_t status, uint16_t chunk_index) {
     uint8_t report[RAW_EPSIZE] = {0};
     report[0] = HID_REPORT_ID_STATUS;
@@ -39,14 +51,7 @@ void send_status_to_host(uint8_t status, uint16_t chunk_index) {
     report[5] = 0xAD;
     report[6] = 0xBE;
     report[7] = 0xEF;
-    // Prefer vendor endpoint if available; fall back to raw HID
-#ifdef VENDOR_ENABLE
-    if (!vendor_send_response(report, RAW_EPSIZE)) {
-        raw_hid_send(report, RAW_EPSIZE);
-    }
-#else
-    raw_hid_send(report, RAW_EPSIZE);
-#endif
+    send_report_to_host(report);
 }
 
 // Convert incoming HID packet to an I2C payload for the ESP32 and log it
@@ -81,6 +86,23 @@ static void convert_hid_i2c(uint8_t *buf, uint8_t length) {
     }
 }
 
+// Binary command reports (hid_reports.h). Their payloads are arbitrary bytes
+// (key indices, millimetres, 0x54 as often as anything), so the legacy ASCII
+// scans must never see them.
+static bool hid_is_command_report(uint8_t report_id) {
+    return (report_id >= HID_REPORT_ID_START_GIF && report_id <= HID_REPORT_ID_STATUS) ||
+           (report_id >= HID_REPORT_ID_SET_THRESHOLD && report_id <= HID_REPORT_ID_GET_TEMPERATURE);
+}
+
+// Report ID as the prefix stripping in hid_process_received_buffer finds it
+static uint8_t hid_peek_report_id(const uint8_t *buf, uint8_t length) {
+    uint8_t i = 0;
+    while (i < length && buf[i] == 0x00) i++;
+    if (i + 1 < length && buf[i] == 0xFF) i++;
+    if (i + 1 < length && buf[i] == HID_PREFIX_APP_MAGIC) i++;
+    return (i < length) ? buf[i] : 0x00;
+}
+
 // Shared processor for a normalized input buffer (used by raw HID and vendor bridge)
 void hid_process_received_buffer(uint8_t *buf, uint8_t length) {
     if (!buf || length == 0) return;
@@ -104,10 +126,12 @@ void hid_process_received_buffer(uint8_t *buf, uint8_t length) {
     // ------------------------------------------------------------------------
     // Scan the first 8 bytes for known ASCII commands. This handles cases where
     // offsets vary (0x00 padding, 0xFF prefix, etc.) without fragile stripping.
+    // Command reports go straight to the dispatch below.
     uint8_t scanned_cmd = 0;
     const uint8_t known_cmds[] = { 'T' }; // Add others like 'S','C','Q','B' if needed
+    bool command_report = hid_is_command_report(hid_peek_report_id(buf, length));
     
-    for (int i = 0; i < length && i < 8; i++) {
+    for (int i = 0; !command_report && i < length && i < 8; i++) {
         for (size_t k = 0; k < sizeof(known_cmds); k++) {
             if (buf[i] == known_cmds[k]) {
                 scanned_cmd = buf[i];
@@ -311,7 +335,232 @@ void hid_process_received_buffer(uint8_t *buf, uint8_t length) {
             send_status_to_host(STATUS_OK, 0);
             break;
         }
+
+        case HID_REPORT_ID_SET_RAPID_TRIGGER: {
+            if (length < 6) {
+                send_status_to_host(STATUS_ERROR_INVALID, 0);
+                break;
+            }
+
+            uint8_t row = buf[1];
+            uint8_t col = buf[2];
+            uint8_t mode = buf[3];
+
+            uint16_t key_idx = (uint16_t)row * MATRIX_COLS + (uint16_t)col;
+            if (key_idx >= (MATRIX_ROWS * MATRIX_COLS) || mode > RAPID_TRIGGER_CONTINUOUS) {
+                send_status_to_host(STATUS_ERROR_INVALID, 0);
+                break;
+            }
+
+            set_key_rapid_trigger(key_idx, mode, buf[4], buf[5]);
+            send_status_to_host(STATUS_OK, 0);
+            break;
+        }
+
+        case HID_REPORT_ID_RECALIBRATE:
+            recalibrate_sensors();  // sampled between scans: ack now
+            send_status_to_host(STATUS_OK, 0);
+            break;
+
+        case HID_REPORT_ID_CAPTURE_BOTTOM_OUT:
+            if (length < 2) {
+                send_status_to_host(STATUS_ERROR_INVALID, 0);
+                break;
+            }
+            capture_bottom_out(buf[1] != 0);
+            send_status_to_host(STATUS_OK, 0);
+            break;
+
+        case HID_REPORT_ID_SET_ACTUATION: {
+            if (length < 7) {
+                send_status_to_host(STATUS_ERROR_INVALID, 0);
+                break;
+            }
+
+            uint8_t row = buf[1];
+            uint8_t col = buf[2];
+            uint16_t actuation = (uint16_t)buf[3] | ((uint16_t)buf[4] << 8);
+            uint16_t reset = (uint16_t)buf[5] | ((uint16_t)buf[6] << 8);
+
+            uint16_t key_idx = (uint16_t)row * MATRIX_COLS + (uint16_t)col;
+            if (key_idx >= (MATRIX_ROWS * MATRIX_COLS)) {
+                send_status_to_host(STATUS_ERROR_INVALID, 0);
+                break;
+            }
+
+            set_key_actuation(key_idx, actuation, reset);
+            send_status_to_host(STATUS_OK, 0);
+            break;
+        }
+
+        case HID_REPORT_ID_SET_SENSITIVITY_SIGMA: {
+            if (length < 4) {
+                send_status_to_host(STATUS_ERROR_INVALID, 0);
+                break;
+            }
+
+            uint16_t key_idx = (uint16_t)buf[1] * MATRIX_COLS + (uint16_t)buf[2];
+            if (key_idx >= (MATRIX_ROWS * MATRIX_COLS)) {
+                send_status_to_host(STATUS_ERROR_INVALID, 0);
+                break;
+            }
+
+            set_key_sensitivity_sigma(key_idx, buf[3]);
+            send_status_to_host(STATUS_OK, 0);
+            break;
+        }
+
+        case HID_REPORT_ID_SET_KEY_PRIORITY: {
+#if MUX_SCAN_PRIORITY
+            if (length < 4) {
+                send_status_to_host(STATUS_ERROR_INVALID, 0);
+                break;
+            }
+
+            uint16_t key_idx = (uint16_t)buf[1] * MATRIX_COLS + (uint16_t)buf[2];
+            if (key_idx >= (MATRIX_ROWS * MATRIX_COLS)) {
+                send_status_to_host(STATUS_ERROR_INVALID, 0);
+                break;
+            }
+
+            set_key_priority(key_idx, buf[3] != 0);
+            send_status_to_host(STATUS_OK, mux_scan_cold_interval());
+#else
+            send_status_to_host(STATUS_ERROR_INVALID, 0);
+#endif
+            break;
+        }
+
+        case HID_REPORT_ID_GET_NOISE_MAP: {
+            // One page of the noise map per request; the host steps the index
+            uint8_t first = (length >= 2) ? buf[1] : 0;
+            uint8_t report[RAW_EPSIZE] = {0};
+            uint8_t count = 0;
+
+            report[0] = HID_REPORT_ID_GET_NOISE_MAP;
+            report[1] = first;
+            for (uint16_t key_idx = first; key_idx < (MATRIX_ROWS * MATRIX_COLS) && 3 + 2 * (count + 1) <= RAW_EPSIZE; key_idx++, count++) {
+                uint16_t noise = get_key_noise_x16(key_idx);
+                report[3 + 2 * count] = noise & 0xFF;
+                report[4 + 2 * count] = (noise >> 8) & 0xFF;
+            }
+            report[2] = count;
+            send_report_to_host(report);
+            break;
+        }
+
+        case HID_REPORT_ID_GET_OVERSAMPLE_MAP: {
+            // Same paging as the noise map
+            uint8_t first = (length >= 2) ? buf[1] : 0;
+            uint8_t report[RAW_EPSIZE] = {0};
+            uint8_t count = 0;
+
+            report[0] = HID_REPORT_ID_GET_OVERSAMPLE_MAP;
+            report[1] = first;
+            for (uint16_t key_idx = first; key_idx < (MATRIX_ROWS * MATRIX_COLS) && 3 + 2 * (count + 1) <= RAW_EPSIZE; key_idx++, count++) {
+                uint16_t samples = get_key_oversamples(key_idx);
+                report[3 + 2 * count] = samples & 0xFF;
+                report[4 + 2 * count] = (samples >> 8) & 0xFF;
+            }
+            report[2] = count;
+            send_report_to_host(report);
+            break;
+        }
         
+        case HID_REPORT_ID_GET_KEY_EVENTS: {
+            // Sample times are the low 32 bits of time_us_64(); latency is
+            // sample to queued report, saturated at 65535 us
+            uint8_t first = (length >= 2) ? buf[1] : 0;
+            uint8_t report[RAW_EPSIZE] = {0};
+            uint8_t count = 0;
+            const key_event_log_t *ev;
+
+            report[0] = HID_REPORT_ID_GET_KEY_EVENTS;
+            report[1] = first;
+            while (3 + 8 * (count + 1) <= RAW_EPSIZE && (ev = key_events_log_get(first + count)) != NULL) {
+                uint8_t *p = &report[3 + 8 * count];
+                uint32_t t = (uint32_t)ev->sample_us;
+                uint16_t latency = (ev->latency_us > 0xFFFF) ? 0xFFFF : ev->latency_us;
+                p[0] = ev->key_idx;
+                p[1] = ev->pressed;
+                p[2] = t & 0xFF;
+                p[3] = (t >> 8) & 0xFF;
+                p[4] = (t >> 16) & 0xFF;
+                p[5] = (t >> 24) & 0xFF;
+                p[6] = latency & 0xFF;
+                p[7] = (latency >> 8) & 0xFF;
+                count++;
+            }
+            report[2] = count;
+            send_report_to_host(report);
+            break;
+        }
+
+        case HID_REPORT_ID_GET_SCAN_STATS: {
+            mux_scan_stats_t stats;
+            uint8_t report[RAW_EPSIZE] = {0};
+            _Static_assert(2 + sizeof(stats) <= RAW_EPSIZE, "scan stats do not fit one report");
+
+            mux_scan_stats(&stats);
+            report[0] = HID_REPORT_ID_GET_SCAN_STATS;
+            report[1] = sizeof(stats);
+            memcpy(&report[2], &stats, sizeof(stats));
+            send_report_to_host(report);
+            break;
+        }
+
+        case HID_REPORT_ID_LEARN_TEMPERATURE:
+#if TEMP_COMPENSATION
+            if (length < 2) {
+                send_status_to_host(STATUS_ERROR_INVALID, 0);
+                break;
+            }
+            learn_temperature(buf[1] != 0);
+            send_status_to_host(STATUS_OK, 0);
+#else
+            send_status_to_host(STATUS_ERROR_INVALID, 0);
+#endif
+            break;
+
+        case HID_REPORT_ID_GET_TEMPERATURE: {
+            mux_temperature_t temp;
+            uint8_t report[RAW_EPSIZE] = {0};
+            _Static_assert(2 + sizeof(temp) <= RAW_EPSIZE, "temperature does not fit one report");
+
+            mux_temperature(&temp);
+            report[0] = HID_REPORT_ID_GET_TEMPERATURE;
+            report[1] = sizeof(temp);
+            memcpy(&report[2], &temp, sizeof(temp));
+            send_report_to_host(report);
+            break;
+        }
+
+        case HID_REPORT_ID_SET_PREDICTION:
+#if KEY_PREDICTIVE_ACTUATION
+            if (length < 2) {
+                send_status_to_host(STATUS_ERROR_INVALID, 0);
+                break;
+            }
+            set_predictive_lead(buf[1]);
+            send_status_to_host(STATUS_OK, 0);
+#else
+            send_status_to_host(STATUS_ERROR_INVALID, 0);
+#endif
+            break;
+
+        case HID_REPORT_ID_CAPTURE_CROSSTALK:
+#if CROSSTALK_COMPENSATION
+            if (length < 2) {
+                send_status_to_host(STATUS_ERROR_INVALID, 0);
+                break;
+            }
+            capture_crosstalk(buf[1] != 0);
+            send_status_to_host(STATUS_OK, 0);
+#else
+            send_status_to_host(STATUS_ERROR_INVALID, 0);
+#endif
+            break;
+
         // This case handles a status report sent *from* the host, if any.
         case HID_REPORT_ID_STATUS:
             // We can just acknowledge it.
@@ -511,7 +760,8 @@ void hid_receive_handler(uint8_t *data, uint8_t length) {
     if (n > 0) memcpy(buf, data, n);
     // First, offer the simple adc_matrix_test-style raw HID handler a chance
     // to process short toggle commands. If it handles the packet, we're done.
-    if (process_rawhid_command(buf, n)) return;
+    // Command reports skip it: its byte scan would take their payload for one.
+    if (!hid_is_command_report(hid_peek_report_id(buf, n)) && process_rawhid_command(buf, n)) return;
 
     // Otherwise fall back to the more complete HID processing flow
     hid_process_received_buffer(buf, n);
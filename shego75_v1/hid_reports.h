@@ -13,6 +13,37 @@
 #define HID_REPORT_ID_STATUS       0x13  // Status responses
 // New: set per-key threshold
 #define HID_REPORT_ID_SET_THRESHOLD 0x20
+// Set per-key rapid trigger: row, col, mode, press delta, release delta (0.01 mm)
+#define HID_REPORT_ID_SET_RAPID_TRIGGER 0x21
+// Measure sensor baselines again and store them (keys must be released)
+#define HID_REPORT_ID_RECALIBRATE   0x22
+// Bottom-out capture: data[1] = 1 to start, 0 to finish and store
+#define HID_REPORT_ID_CAPTURE_BOTTOM_OUT 0x23
+// Set per-key actuation: row, col, actuation (u16 LE), reset (u16 LE), 0.01 mm
+#define HID_REPORT_ID_SET_ACTUATION 0x24
+// Set per-key sensitivity in noise multiples: row, col, multiple (0 = percent)
+#define HID_REPORT_ID_SET_SENSITIVITY_SIGMA 0x25
+// Read the noise map: first key index -> reply 0x26, first, count, count x u16 LE
+#define HID_REPORT_ID_GET_NOISE_MAP 0x26
+// Set per-key scan priority: row, col, 1 = hot / 0 = cold (MUX_SCAN_PRIORITY);
+// the OK status carries the cold keys' worst-case staleness in passes
+#define HID_REPORT_ID_SET_KEY_PRIORITY 0x27
+// Read the key event log, oldest first: first -> reply 0x28, first, count, then
+// count x (key index, pressed, sample time u32 LE us, latency u16 LE us)
+#define HID_REPORT_ID_GET_KEY_EVENTS 0x28
+// Read the scan pipeline counters -> reply 0x29, size, mux_scan_stats_t
+#define HID_REPORT_ID_GET_SCAN_STATS 0x29
+// Set predictive actuation lead: percent of a sample interval (0 = off)
+#define HID_REPORT_ID_SET_PREDICTION 0x2A
+// Crosstalk capture: data[1] = 1 to start, 0 to finish and store
+#define HID_REPORT_ID_CAPTURE_CROSSTALK 0x2B
+// Read per-key oversampled samples over the last second (MUX_SCAN_OVERSAMPLE):
+// first key index -> reply 0x2C, first, count, count x u16 LE
+#define HID_REPORT_ID_GET_OVERSAMPLE_MAP 0x2C
+// Temperature warm-up calibration: data[1] = 1 to start, 0 to finish and store
+#define HID_REPORT_ID_LEARN_TEMPERATURE 0x2D
+// Read the board temperature -> reply 0x2E, size, mux_temperature_t
+#define HID_REPORT_ID_GET_TEMPERATURE 0x2E
 // Custom: trigger LED_TOG keycode from host
 // Historically this used 0x30; accept 0x54 ('T') as the primary command now.
 #define HID_REPORT_ID_LED_TOGGLE    0x54
@@ -0,0 +1,82 @@
+// key_events.c - SPSC ring of key transitions
+// head is written only by the producer and tail only by the consumer; both
+// run free and are reduced modulo the length on access. The barriers order
+// the slot contents against the index that publishes or releases them.
+#include "key_events.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include <stddef.h>
+
+static key_event_t ring[KEY_EVENT_QUEUE_LEN];
+static volatile uint32_t head = 0;
+static volatile uint32_t tail = 0;
+static volatile bool overflow = false;
+
+bool key_events_push(uint64_t time_us, uint32_t seq, uint8_t key_idx, bool pressed) {
+    uint32_t h = head;
+    if (h - tail >= KEY_EVENT_QUEUE_LEN) {
+        overflow = true;
+        return false;
+    }
+    ring[h & (KEY_EVENT_QUEUE_LEN - 1)] = (key_event_t){
+        .time_us = time_us,
+        .seq = seq,
+        .key_idx = key_idx,
+        .pressed = pressed,
+    };
+    __dmb();  // slot before index
+    head = h + 1;
+    return true;
+}
+
+const key_event_t *key_events_peek(void) {
+    uint32_t t = tail;
+    if (t == head) {
+        return NULL;
+    }
+    __dmb();  // index before slot
+    return &ring[t & (KEY_EVENT_QUEUE_LEN - 1)];
+}
+
+void key_events_drop(void) {
+    __dmb();  // finish reading the slot before handing it back
+    tail = tail + 1;
+}
+
+bool key_events_overflowed(void) {
+    return overflow;
+}
+
+void key_events_flush(void) {
+    overflow = false;
+    __dmb();
+    tail = head;
+}
+
+static key_event_log_t event_log[KEY_EVENT_LOG_LEN];
+static uint32_t log_next = 0;
+
+void key_events_log(uint8_t key_idx, bool pressed, uint64_t sample_us) {
+    uint64_t now = time_us_64();
+    uint64_t latency = (sample_us && now > sample_us) ? now - sample_us : 0;
+
+    event_log[log_next % KEY_EVENT_LOG_LEN] = (key_event_log_t){
+        .sample_us  = sample_us,
+        .latency_us = (latency > UINT32_MAX) ? UINT32_MAX : (uint32_t)latency,
+        .key_idx    = key_idx,
+        .pressed    = pressed,
+    };
+    log_next++;
+}
+
+uint8_t key_events_log_count(void) {
+    return (log_next < KEY_EVENT_LOG_LEN) ? log_next : KEY_EVENT_LOG_LEN;
+}
+
+const key_event_log_t *key_events_log_get(uint8_t n) {
+    uint8_t count = key_events_log_count();
+    if (n >= count) {
+        return NULL;
+    }
+    return &event_log[(log_next - count + n) % KEY_EVENT_LOG_LEN];
+}
@@ -0,0 +1,55 @@
+/* key_events.h - timestamped key transitions from the scanner to QMK */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Queue depth (power of two). A full queue drops new events and raises the
+// overflow flag; the consumer then resynchronises from the latest matrix.
+#ifndef KEY_EVENT_QUEUE_LEN
+#define KEY_EVENT_QUEUE_LEN 64
+#endif
+_Static_assert((KEY_EVENT_QUEUE_LEN & (KEY_EVENT_QUEUE_LEN - 1)) == 0, "KEY_EVENT_QUEUE_LEN must be a power of two");
+
+typedef struct {
+    uint64_t time_us;  // time_us_64() of the sample that committed the change
+    uint32_t seq;      // snapshot sequence the committing pass publishes
+    uint8_t key_idx;   // row * MATRIX_COLS + col
+    bool pressed;      // new state
+} key_event_t;
+
+// Single producer (the scanner) and single consumer (matrix_scan_custom),
+// possibly on different cores; lock-free, no interrupts masked.
+
+// Producer: append an event. Returns false (and sets the overflow flag) when
+// the queue is full.
+bool key_events_push(uint64_t time_us, uint32_t seq, uint8_t key_idx, bool pressed);
+
+// Consumer: oldest event without removing it, or NULL when empty
+const key_event_t *key_events_peek(void);
+// Consumer: remove the event returned by key_events_peek()
+void key_events_drop(void);
+// Consumer: true once an event has been dropped for lack of space
+bool key_events_overflowed(void);
+// Consumer: discard everything queued and clear the overflow flag
+void key_events_flush(void);
+
+// Log of the last KEY_EVENT_LOG_LEN changes QMK acted on (core0 only), for
+// latency accounting from the host
+#ifndef KEY_EVENT_LOG_LEN
+#define KEY_EVENT_LOG_LEN 32
+#endif
+
+typedef struct {
+    uint64_t sample_us;   // time_us_64() of the sample that committed it
+    uint32_t latency_us;  // from that sample until its report was queued
+    uint8_t key_idx;
+    bool pressed;
+} key_event_log_t;
+
+// Record a change at the point its report is queued (process_record_user)
+void key_events_log(uint8_t key_idx, bool pressed, uint64_t sample_us);
+// Number of entries logged, up to KEY_EVENT_LOG_LEN
+uint8_t key_events_log_count(void);
+// Entry n of the log, oldest first; NULL past the end
+const key_event_log_t *key_events_log_get(uint8_t n);
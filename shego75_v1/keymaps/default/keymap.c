@@ -121,7 +121,7 @@ void keyboard_post_init_user(void) {
     // Now safe to send debug messages
     uart_send_string("[keymap] keyboard_post_init_user\n");
     
-    // Perform sensor auto-calibration (must be done with no keys pressed!)
+    // Load stored sensor calibration, or measure one (must be done with no keys pressed!)
     uart_send_string("[keymap] Calibrating sensors...\n");
     calibrate_sensors();
     uart_send_string("[keymap] Calibration complete!\n");
@@ -131,8 +131,8 @@ void keyboard_post_init_user(void) {
     wait_ms(100);  // Give ESP32 time to be ready
     i2c_esp32_test();  // Test connection
     
-    // Enable RGB matrix and lighting
-    rgb_matrix_enable();
+    // Enable RGB matrix and lighting (no EEPROM write on every boot)
+    rgb_matrix_enable_noeeprom();
     lighting_init();
 }
 
@@ -10,68 +10,1648 @@
 #include "debug.h"
 #include "timer.h"
 #include "print.h"
+#include "core1.h"
+#include "calibration.h"
+#include "analog_matrix.h"
+#include "key_events.h"
+#include "travel_lut.h"
+#include "mux_pio.h"
+#include "hardware/adc.h"
+#include "hardware/timer.h"
+#include "hardware/sync.h"
+#include "hardware/address_mapped.h"
+#include "hardware/regs/addressmap.h"
+#include "hardware/regs/usb.h"
+#include "hardware/regs/m0plus.h"
+#include "hardware/structs/scb.h"
+#include "hardware/structs/timer.h"
 #include <stdio.h>
 #include <string.h>
 
-#define DEBOUNCE_MS 2  // Reduced from 5ms to 2ms for faster response
+// ESP_RESET_PIN definition (GP3 - bootloader trigger pin, must be HIGH during boot)
+#ifndef ESP_RESET_PIN
+#define ESP_RESET_PIN GP3
+#endif
+
+// Key state tracking for 81 keys (6 rows × 15 cols max)
+// Using MATRIX_ROWS * MATRIX_COLS = 6 * 15 = 90 slots to be safe
+#define MAX_KEYS (MATRIX_ROWS * MATRIX_COLS)
+
+// Filtered samples from the last pass, indexed by key (also used for the ADC debug table)
+static uint16_t adc_frame[MAX_KEYS];
+static uint32_t last_adc_print_time = 0;
+#define ADC_PRINT_INTERVAL_MS 1000  // Print every 1000ms (1 second)
+
+// NOTE: On this board the ADG732 EN pins are grounded (always enabled).
+// We therefore select each ADG732 using its CS pin (active low) and latch
+// addresses with the WR pin. If you have external EN pins, you can enable
+// them by defining MUX1_EN / MUX2_EN / MUX3_EN in your board config.
+
+static bool key_pressed[MAX_KEYS];
+static uint8_t key_confirm[MAX_KEYS];        // Consecutive samples disagreeing with key_pressed
+
+// Auto-calibration storage
+static uint16_t key_baseline[MAX_KEYS];      // Baseline (resting) ADC value for each key
+static uint16_t key_threshold[MAX_KEYS];     // (legacy) absolute threshold - kept for compatibility
+static uint8_t key_sensitivity_percent[MAX_KEYS]; // Sensitivity percent per key (deviation percent)
+static bool calibration_complete = false;    // Flag indicating calibration status
+static bool calibration_dirty = false;       // Sensitivities changed since the last save
+static uint32_t calibration_dirty_time = 0;
+
+// Travel (ADC counts from baseline) at bottom-out, used to normalize the
+// analog travel; captured on request, ANALOG_BOTTOM_OUT_DEFAULT until then
+static uint16_t key_bottom_out[MAX_KEYS];
+static uint16_t key_capture_min[MAX_KEYS];     // extremes seen while capturing
+static uint16_t key_capture_max[MAX_KEYS];
+static volatile bool bottom_out_capture = false;
+
+// Direction a key's reading moves when pressed: 1 = up, -1 = down, 0 = not
+// known yet (both sides count). Only a bottom-out capture sets it: the rest
+// offset does not say which pole faces the sensor.
+static int8_t key_polarity[MAX_KEYS];
+
+// Resting noise (standard deviation, ADC counts x16) measured at calibration,
+// and sensitivity in multiples of it (0 = use the sensitivity percent)
+static uint16_t key_noise_x16[MAX_KEYS];
+static uint8_t key_sensitivity_sigma[MAX_KEYS];
+
+// time_us_64() of each key's latest sample (scanner side), and of the sample
+// behind its latest matrix change as seen by QMK (core0 side)
+static uint64_t key_sample_us[MAX_KEYS];
+static uint64_t key_change_us[MAX_KEYS];
+
+#if CROSSTALK_COMPENSATION
+// Magnetic crosstalk: a key's offset from its baseline, times
+// key_crosstalk_coef (Q12), leaks into key key_crosstalk_target; a zero
+// coefficient is an unused slot. Measured by capture_crosstalk().
+static uint8_t key_crosstalk_target[MAX_KEYS][CROSSTALK_NEIGHBORS];
+static int16_t key_crosstalk_coef[MAX_KEYS][CROSSTALK_NEIGHBORS];
+static volatile bool crosstalk_capture = false;
+// Capture state (scanner side): the key currently held alone, the passes
+// seen so far, and every key's summed offset from rest over them
+#define CROSSTALK_NO_SOURCE 0xFF
+static uint8_t crosstalk_source = CROSSTALK_NO_SOURCE;
+static uint16_t crosstalk_passes;
+static int32_t crosstalk_sum[MAX_KEYS];
+#endif
+
+#if MUX_SCAN_PARALLEL
+// Order the parallel scan visits addresses in: the plan index of the first
+// entry of each address group. Plan order until optimize_scan_order() runs.
+static uint8_t scan_order[32];
+static uint8_t scan_order_len;
+#endif
+
+#if MUX_SCAN_PIO
+// The PIO engine is running; false falls back to the parallel CPU scan
+// (no free state machine, program space or DMA channel at init)
+static bool pio_scan = false;
+#endif
+
+#if MUX_SCAN_PRIORITY
+// Priority schedule: hot keys' addresses are sampled every pass, cold ones
+// SCAN_COLD_SLICE at a time in rotation. cold_rank[o] is the rotation slot
+// of scan_order[o] (SCAN_RANK_HOT for hot addresses); the scanner rebuilds
+// it whenever a priority changes.
+#define SCAN_RANK_HOT 0xFF
+static uint8_t key_priority[MAX_KEYS];
+static uint8_t cold_rank[32];
+static uint8_t cold_len;
+static uint8_t cold_cursor;
+static volatile bool scan_schedule_dirty;
+// Calibration sets this so every pass samples every key
+static volatile bool scan_full_passes;
+// Keys sampled in the current frame; the others hold their last reading
+static bool key_fresh[MAX_KEYS];
+#define KEY_SAMPLED(key_idx) (key_fresh[key_idx])
+#else
+#define KEY_SAMPLED(key_idx) true
+#endif
+
+#if MUX_SCAN_OVERSAMPLE
+// Keys whose last travel sat near their next decision point (scanner side,
+// from evaluate_frame); their address is oversampled in the next pass
+static bool key_near_decision[MAX_KEYS];
+// Oversampled samples per key in the current stats window, and over the
+// last full one
+static uint16_t key_oversamples[MAX_KEYS];
+static uint16_t key_oversample_rate[MAX_KEYS];
+#endif
+
+#if TEMP_COMPENSATION
+// Smoothed board temperature (0.01 degC, scanner side), the temperature the
+// stored baselines were measured at, and the one the bands were last
+// adjusted for. Per key: resting-value slope (ADC counts per degC, Q8) and
+// the offset it currently adds to the baseline.
+static volatile int16_t temp_now_x100;
+static int16_t temp_ref_x100;
+static int16_t temp_applied_x100;
+static uint32_t temp_last_us;
+static int16_t key_temp_coef_q8[MAX_KEYS];
+static int16_t key_temp_offset[MAX_KEYS];
+// Warm-up fit: least-squares sums of every key's rest value against
+// temperature, both relative to the first sample. The scanner adds to them
+// between passes; core0 starts, stops and fits with the scanner held.
+static volatile bool temp_learning = false;
+static struct {
+    uint16_t n;
+    int16_t t0;
+    int16_t t_min;
+    int16_t t_max;
+    int64_t sum_t;
+    int64_t sum_tt;
+} temp_fit;
+static uint16_t temp_fit_x0[MAX_KEYS];
+static int32_t temp_fit_sum_x[MAX_KEYS];
+static int64_t temp_fit_sum_tx[MAX_KEYS];
+#endif
+
+#if MUX_SETTLE_ADAPTIVE
+// Settle wait per mux address, measured at boot by measure_settle_times()
+static uint16_t address_settle_us[32];
+#define ADDRESS_SETTLE_US(ch) (address_settle_us[ch])
+#else
+#define ADDRESS_SETTLE_US(ch) MUX_SETTLE_US
+#endif
+
+#if SPIKE_FILTER
+// Previous two samples per key for the median-of-3 spike filter
+static uint16_t key_history[MAX_KEYS][2];
+static bool key_history_primed = false;
+#endif
+
+// Hall curve linearization per key, rebuilt from baseline and bottom-out
+static travel_lut_t key_lut[MAX_KEYS];
+
+// Actuation and reset points in 0.01 mm; actuation 0 = use the sensitivity
+// percent instead, reset 0 = KEY_RELEASE_PERCENT of the actuation point
+static uint16_t key_actuation_mm_x100[MAX_KEYS];
+static uint16_t key_reset_mm_x100[MAX_KEYS];
+
+#if BASELINE_DRIFT_TRACKING
+// Drift tracker state: smoothed resting value (<< BASELINE_DRIFT_SHIFT) and
+// the calibrated baseline that drift is limited around
+static uint32_t key_baseline_acc[MAX_KEYS];
+static uint16_t key_baseline_cal[MAX_KEYS];
+#endif
+
+// Per-key trigger points, cached so evaluate_frame only compares. Once
+// calibrated, a key presses when its linearized travel reaches press_depth
+// and releases when it falls below the shallower release_depth (hysteresis,
+// so a key hovering at the press point cannot chatter). The raw ADC bands
+// [press_lo, press_hi] / [release_lo, release_hi] are the sensitivity
+// percent points, used before calibration and as the drift tracker's guard.
+// Rebuilt by update_key_band() whenever anything behind them changes.
+typedef struct {
+    uint16_t base;          // resting value that travel is measured from
+    uint16_t press_lo;
+    uint16_t press_hi;
+    uint16_t release_lo;
+    uint16_t release_hi;
+    uint16_t bottom_out;    // travel at bottom-out (ADC counts)
+    uint32_t travel_scale;  // counts -> ANALOG_TRAVEL units, Q16
+    uint16_t press_depth;   // linearized travel (ANALOG_TRAVEL units) that actuates
+    uint16_t release_depth; // linearized travel below which a pressed key releases
+    int8_t polarity;        // copy of key_polarity
+} key_band_t;
+static key_band_t key_band[MAX_KEYS];
+
+// Per-key rapid trigger state, kept to 8 bytes so the whole table stays small.
+// Travel and deltas are linearized (ANALOG_TRAVEL units).
+typedef struct {
+    uint16_t extreme;       // deepest travel while pressed, shallowest while released
+    uint16_t press_delta;   // travel back down that re-actuates
+    uint16_t release_delta; // travel back up that releases
+    uint8_t mode;           // RAPID_TRIGGER_OFF / _ON / _CONTINUOUS
+    bool armed;             // inside the rapid trigger zone
+} key_rt_t;
+_Static_assert(sizeof(key_rt_t) <= 8, "key_rt_t grew");
+static key_rt_t key_rt[MAX_KEYS];
+
+#if KEY_PREDICTIVE_ACTUATION
+// Alpha-beta tracker per key: position and velocity of the linearized
+// travel, both in ANALOG_TRAVEL units << PREDICT_FRAC_BITS, velocity per
+// sample of that key
+#define PREDICT_FRAC_BITS 4
+typedef struct {
+    int32_t x;
+    int32_t v;
+} key_track_t;
+static key_track_t key_track[MAX_KEYS];
+// Press committed before the travel reached the actuation point; resolved
+// as a hit when it gets there, as a false actuation if released first
+static bool key_predicted[MAX_KEYS];
+// How far ahead to extrapolate, in percent of the key's sample interval (0 = off)
+static uint8_t predict_lead_percent = PREDICT_LEAD_PERCENT;
+#endif
+
+// Snapshot published by the core1 scanner and copied by matrix_scan_custom.
+// Seqlock: the writer makes seq odd while updating and even when done; a
+// reader retries if seq was odd or changed while it copied.
+typedef struct {
+    volatile uint32_t seq;
+    matrix_row_t matrix[MATRIX_ROWS];
+    uint16_t frame[MAX_KEYS];
+} scan_snapshot_t;
+static scan_snapshot_t scan_snapshot;
+
+// Pipeline counters, kept by whichever core runs the scan: the current
+// one-second window accumulates, then becomes the published stats (seqlock,
+// read by core0 through mux_scan_stats)
+static struct {
+    uint32_t start_us;
+    uint32_t passes;
+    uint32_t pass_us_sum;
+    uint32_t pass_us_min;
+    uint32_t pass_us_max;
+    uint32_t settle_us;
+    uint32_t adc_us;
+    uint32_t invalid;
+    uint32_t spikes;
+    uint32_t changes;
+    uint32_t predicted;
+    uint32_t predict_false;
+    uint32_t oversampled;
+} scan_window;
+static mux_scan_stats_t scan_stats;
+static volatile uint32_t scan_stats_seq = 0;
+
+// Scan governor state (inline scan on core0 only)
+#define USB_FRAME_US 1000
+static uint32_t scan_pass_us = 0;        // Smoothed duration of one pass
+static uint32_t sof_time_us = 0;         // Estimated start of the current USB frame
+static uint16_t sof_frame = 0;           // Frame number that sof_time_us belongs to
+static uint16_t scanned_frame = 0xFFFF;  // Frame the last pass was started in
+
+// Debug counter to limit output
+// Debug counters (may be used later); mark volatile to avoid unused warnings
+static volatile uint32_t debug_counter = 0;
+static volatile uint32_t last_debug_time = 0;
+
+// Helper for reading ADC
+// Helper for reading ADC (kept static but may be unused in diagnostic stub)
+// (10-bit: the wide 12-bit codes are already merged, so no DNL correction)
+static inline uint16_t read_adc_pin(pin_t pin) {
+    return analogReadPin(pin);
+}
+
+// Core-agnostic delay: reads the RP2040 timer directly so the scan loop can
+// run on core1, where ChibiOS timer/wait helpers are not safe to call.
+static inline void scan_wait_us(uint32_t us) {
+    uint32_t start = time_us_32();
+    while ((time_us_32() - start) < us) {
+    }
+}
+
+// Read all three mux outputs back to back using the RP2040 ADC round-robin.
+// Inputs 0..2 are GP26..GP28 (MUX1..MUX3); with the round-robin mask set,
+// each conversion advances AINSEL so out[] comes back in mux order.
+static inline void read_adc_round_robin(uint16_t out[3]) {
+    adc_select_input(0);
+    adc_set_round_robin(0x07);
+    for (uint8_t i = 0; i < 3; i++) {
+        out[i] = adc_correct_dnl(adc_read()) >> MUX_ADC_RESULT_SHIFT;
+    }
+    adc_set_round_robin(0);
+}
+
+#if MUX_SCAN_OVERSAMPLE
+// Like read_adc_round_robin, averaging `reads` conversions per mux taken
+// back to back on the latched address (no further settle wait). The sums
+// stay at 12 bits so the extra resolution survives the rounding.
+static inline void read_adc_round_robin_avg(uint16_t out[3], uint8_t reads) {
+    uint32_t sum[3] = {0, 0, 0};
+    uint32_t div = (uint32_t)reads << MUX_ADC_RESULT_SHIFT;
+
+    adc_select_input(0);
+    adc_set_round_robin(0x07);
+    for (uint8_t r = 0; r < reads; r++) {
+        for (uint8_t i = 0; i < 3; i++) {
+            sum[i] += adc_correct_dnl(adc_read());
+        }
+    }
+    adc_set_round_robin(0);
+    for (uint8_t i = 0; i < 3; i++) {
+        out[i] = (uint16_t)((sum[i] + div / 2) / div);
+    }
+}
+#endif
+
+#if MUX_SETTLE_DITHER_US
+// Extra settle wait for the next address, 0..MUX_SETTLE_DITHER_US (xorshift32)
+static inline uint32_t settle_dither_us(void) {
+    static uint32_t state = 0x2545F491u;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state % (MUX_SETTLE_DITHER_US + 1);
+}
+#define SETTLE_DITHER_US() settle_dither_us()
+#else
+#define SETTLE_DITHER_US() 0
+#endif
+
+// Helper for selecting MUX channel
+// Helper to select MUX channel (kept inline to avoid unused-function error)
+static inline void select_mux_channel(uint8_t channel) {
+    // Set address lines (A0..A4)
+    writePin(MUX_A0, (channel & 0x01) ? 1 : 0);
+    writePin(MUX_A1, (channel & 0x02) ? 1 : 0);
+    writePin(MUX_A2, (channel & 0x04) ? 1 : 0);
+    writePin(MUX_A3, (channel & 0x08) ? 1 : 0);
+    writePin(MUX_A4, (channel & 0x10) ? 1 : 0);
+
+    // Pulse WR low to latch the address into the ADG732 (falling edge triggers latch)
+#ifdef MUX_WR
+    writePinLow(MUX_WR);
+    scan_wait_us(5); // short pulse to ensure latch
+    writePinHigh(MUX_WR);
+#else
+    // If no WR pin is defined, give address lines time to settle
+    scan_wait_us(50);
+#endif
+}
+
+// Drive the ADG732 chip selects. mux_idx 0..2 selects a single chip;
+// MUX_CS_ALL pulls all three low so one WR pulse latches the same address
+// into every mux (they share A0-A4 and WR).
+#define MUX_CS_ALL 0xFF
+static inline void mux_cs_select(uint8_t mux_idx) {
+#ifdef MUX_CS1
+    if (mux_idx == 0 || mux_idx == MUX_CS_ALL) { writePinLow(MUX_CS1); } else { writePinHigh(MUX_CS1); }
+#endif
+#ifdef MUX_CS2
+    if (mux_idx == 1 || mux_idx == MUX_CS_ALL) { writePinLow(MUX_CS2); } else { writePinHigh(MUX_CS2); }
+#endif
+#ifdef MUX_CS3
+    if (mux_idx == 2 || mux_idx == MUX_CS_ALL) { writePinLow(MUX_CS3); } else { writePinHigh(MUX_CS3); }
+#endif
+}
+
+// Release all chip selects (EN is grounded, so outputs stay live)
+static inline void mux_cs_release(void) {
+#ifdef MUX_CS1
+    writePinHigh(MUX_CS1);
+#endif
+#ifdef MUX_CS2
+    writePinHigh(MUX_CS2);
+#endif
+#ifdef MUX_CS3
+    writePinHigh(MUX_CS3);
+#endif
+}
+
+// Filter out anomalous high values (crosstalk without filter caps)
+// Valid Hall sensor range: 0 (pressed) to ~512 (released)
+// Values above 800 are likely crosstalk
+static inline uint16_t filter_adc_sample(uint16_t adc_val) {
+    const uint16_t ADC_MAX_VALID = 800;
+    if (adc_val > ADC_MAX_VALID) {
+        adc_val = 4095;  // Treat as invalid/unpressed
+        scan_window.invalid++;
+    }
+    return adc_val;
+}
+
+#if SPIKE_FILTER
+static inline uint16_t median3(uint16_t a, uint16_t b, uint16_t c) {
+    uint16_t lo = (a < b) ? a : b;
+    uint16_t hi = (a < b) ? b : a;
+    return (c < lo) ? lo : (c > hi) ? hi : c;
+}
+
+// Replace each sample with the median of it and the key's previous two, so
+// a single-pass spike (crosstalk, or an invalid 4095) never reaches the
+// evaluation or calibration. Costs one pass of delay on genuine steps.
+static void despike_frame(uint16_t frame[MAX_KEYS]) {
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        uint8_t key_idx = scan_plan[i].key_idx;
+        if (!KEY_SAMPLED(key_idx)) {
+            continue;  // a held reading is not a new sample
+        }
+        uint16_t *hist = key_history[key_idx];
+        uint16_t sample = frame[key_idx];
+
+        if (!key_history_primed) {
+            hist[0] = hist[1] = sample;
+        }
+        frame[key_idx] = median3(hist[0], hist[1], sample);
+        scan_window.spikes += frame[key_idx] != sample;
+        hist[0] = hist[1];
+        hist[1] = sample;
+    }
+    key_history_primed = true;
+}
+#endif
+
+#if MUX_SCAN_PRIORITY
+// Number the cold addresses along scan_order (scanner side only, so the
+// schedule never changes under a running pass)
+static void rebuild_scan_schedule(void) {
+    cold_len = 0;
+    for (uint8_t o = 0; o < scan_order_len; o++) {
+        bool hot = false;
+        uint8_t ch = scan_plan[scan_order[o]].channel;
+        for (uint8_t i = scan_order[o]; i < SCAN_PLAN_LEN && scan_plan[i].channel == ch; i++) {
+            hot |= key_priority[scan_plan[i].key_idx] != 0;
+        }
+        cold_rank[o] = hot ? SCAN_RANK_HOT : cold_len++;
+    }
+    cold_cursor = 0;
+}
+#endif
+
+#if CROSSTALK_COMPENSATION
+// Subtract each key's leak into its measured neighbours. The corrections
+// come from the uncorrected offsets (first-order unmixing) and only touch
+// valid samples taken this pass; at most SCAN_PLAN_LEN x CROSSTALK_NEIGHBORS
+// multiply-adds.
+static void compensate_crosstalk(uint16_t frame[MAX_KEYS]) {
+    int16_t correction[MAX_KEYS] = {0};
+
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        uint8_t src = scan_plan[i].key_idx;
+        if (frame[src] == 4095) {
+            continue;
+        }
+        int32_t offset = (int32_t)frame[src] - key_baseline[src];
+        for (uint8_t n = 0; n < CROSSTALK_NEIGHBORS; n++) {
+            int32_t coef = key_crosstalk_coef[src][n];
+            if (coef) {
+                correction[key_crosstalk_target[src][n]] += (int16_t)((coef * offset + 2048) >> 12);
+            }
+        }
+    }
+
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        uint8_t key_idx = scan_plan[i].key_idx;
+        if (!correction[key_idx] || frame[key_idx] == 4095 || !KEY_SAMPLED(key_idx)) {
+            continue;  // a held reading was corrected when it was taken
+        }
+        int32_t v = (int32_t)frame[key_idx] - correction[key_idx];
+        frame[key_idx] = (v < 0) ? 0 : (v > 1023) ? 1023 : (uint16_t)v;
+    }
+}
+#endif
+
+#if MUX_SCAN_PIO
+// The PIO/DMA engine scans on its own; just take its latest pass
+static void scan_pio_frame(uint16_t frame[MAX_KEYS]) {
+    static uint16_t raw[3][32];
+    mux_pio_read_frame(raw);
+    uint64_t now = time_us_64();  // the engine's passes are not stamped per address
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        const scan_plan_entry_t *e = &scan_plan[i];
+        frame[e->key_idx] = filter_adc_sample(raw[e->mux][e->channel]);
+        key_sample_us[e->key_idx] = now;
+    }
+}
+#endif
+
+// Parallel mode latches each address into all three ADG732s with a single
+// WR pulse and pays one settle wait per address instead of one per mux.
+static void scan_cpu_frame(uint16_t frame[MAX_KEYS]) {
+#if MUX_SCAN_PARALLEL
+    uint16_t sample[3];
+
+#if MUX_SCAN_PRIORITY
+    if (scan_schedule_dirty) {
+        scan_schedule_dirty = false;
+        rebuild_scan_schedule();
+    }
+    bool full = scan_full_passes || cold_len <= SCAN_COLD_SLICE;
+    memset(key_fresh, 0, sizeof(key_fresh));
+#endif
+
+    mux_cs_select(MUX_CS_ALL);
+    for (uint8_t o = 0; o < scan_order_len; o++) {
+        uint8_t i = scan_order[o];
+#if MUX_SCAN_PRIORITY
+        // Cold addresses outside this pass's slice of the rotation wait
+        uint8_t rank = cold_rank[o];
+        if (!full && rank != SCAN_RANK_HOT && (uint8_t)((rank + cold_len - cold_cursor) % cold_len) >= SCAN_COLD_SLICE) {
+            continue;
+        }
+#endif
+        uint8_t ch = scan_plan[i].channel;
+        select_mux_channel(ch);
+        uint32_t settle_start = time_us_32();
+        scan_wait_us(ADDRESS_SETTLE_US(ch) + SETTLE_DITHER_US());  // Settling without filter caps
+
+        uint32_t read_start = time_us_32();
+#if MUX_SCAN_OVERSAMPLE
+        // One key near its decision point is enough to oversample the address
+        uint8_t reads = 1;
+        for (uint8_t j = i; j < SCAN_PLAN_LEN && scan_plan[j].channel == ch; j++) {
+            if (key_near_decision[scan_plan[j].key_idx]) reads = MUX_OVERSAMPLE_COUNT;
+        }
+        read_adc_round_robin_avg(sample, reads);
+#else
+        read_adc_round_robin(sample);
+#endif
+        uint64_t now = time_us_64();
+        scan_window.settle_us += read_start - settle_start;
+        scan_window.adc_us += (uint32_t)now - read_start;
+        // The plan is address-major: consume every entry on this address
+        for (; i < SCAN_PLAN_LEN && scan_plan[i].channel == ch; i++) {
+            const scan_plan_entry_t *e = &scan_plan[i];
+            frame[e->key_idx] = filter_adc_sample(sample[e->mux]);
+            key_sample_us[e->key_idx] = now;
+#if MUX_SCAN_OVERSAMPLE
+            if (reads > 1) {
+                key_oversamples[e->key_idx]++;
+                scan_window.oversampled++;
+            }
+#endif
+#if MUX_SCAN_PRIORITY
+            key_fresh[e->key_idx] = true;
+#endif
+        }
+    }
+    mux_cs_release();
+
+#if MUX_SCAN_PRIORITY
+    if (!full) {
+        cold_cursor = (uint8_t)((cold_cursor + SCAN_COLD_SLICE) % cold_len);
+    }
+#endif
+#else
+    const pin_t adc_pins[3] = {MUX1_ADC_PIN, MUX2_ADC_PIN, MUX3_ADC_PIN};
+
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        const scan_plan_entry_t *e = &scan_plan[i];
+        mux_cs_select(e->mux);
+        select_mux_channel(e->channel);
+        uint32_t settle_start = time_us_32();
+        scan_wait_us(MUX_SETTLE_US + SETTLE_DITHER_US());  // Settling without filter caps
+
+        uint32_t read_start = time_us_32();
+        uint16_t raw = read_adc_pin(adc_pins[e->mux]);
+#if MUX_SCAN_OVERSAMPLE
+        if (key_near_decision[e->key_idx]) {
+            uint32_t sum = raw;
+            for (uint8_t r = 1; r < MUX_OVERSAMPLE_COUNT; r++) {
+                sum += read_adc_pin(adc_pins[e->mux]);
+            }
+            raw = (uint16_t)((sum + MUX_OVERSAMPLE_COUNT / 2) / MUX_OVERSAMPLE_COUNT);
+            key_oversamples[e->key_idx]++;
+            scan_window.oversampled++;
+        }
+#endif
+        frame[e->key_idx] = filter_adc_sample(raw);
+        key_sample_us[e->key_idx] = time_us_64();
+        scan_window.settle_us += read_start - settle_start;
+        scan_window.adc_us += (uint32_t)key_sample_us[e->key_idx] - read_start;
+    }
+    // Release CS (keep all muxes disabled between passes)
+    mux_cs_release();
+#endif
+}
+
+// Sample every wired input once into frame[key_idx] (filtered values),
+// walking the compile-time scan plan so unwired inputs cost nothing. Both
+// the scan and calibration take their samples from here, spike filter
+// included.
+static void scan_mux_frame(uint16_t frame[MAX_KEYS]) {
+#if MUX_SCAN_PIO
+    if (pio_scan) {
+        scan_pio_frame(frame);
+    } else {
+        scan_cpu_frame(frame);
+    }
+#else
+    scan_cpu_frame(frame);
+#endif
+
+#if SPIKE_FILTER
+    despike_frame(frame);
+#endif
+#if CROSSTALK_COMPENSATION
+    // Off while capturing, which needs the raw coupling
+    if (calibration_complete && !crosstalk_capture) {
+        compensate_crosstalk(frame);
+    }
+#endif
+}
+
+// Distance of a sample from the key's resting value on its pressed side
+// (either side while the polarity is unknown); the other side reads 0
+static inline uint16_t key_travel(const key_band_t *b, uint16_t adc_val) {
+    uint16_t up = (adc_val > b->base) ? adc_val - b->base : 0;
+    uint16_t down = (adc_val < b->base) ? b->base - adc_val : 0;
+    return (b->polarity > 0) ? up : (b->polarity < 0) ? down : (up | down);
+}
+
+// Linearized travel (ANALOG_TRAVEL units) for a distance in ADC counts:
+// normalize by bottom-out, then map through the key's hall curve
+static inline uint16_t key_depth(uint8_t key_idx, const key_band_t *b, uint16_t counts) {
+    uint16_t signal = (counts >= b->bottom_out) ? ANALOG_TRAVEL_FULL : (uint16_t)((counts * b->travel_scale) >> 16);
+    return travel_lut_eval(&key_lut[key_idx], signal);
+}
+
+// Counts from rest to a band edge on the key's pressed side (the nearer
+// edge while the polarity is unknown, since either side presses)
+static inline uint16_t band_counts(const key_band_t *b, uint16_t lo, uint16_t hi) {
+    uint16_t down = b->base - lo;
+    uint16_t up = hi - b->base;
+    return (b->polarity > 0) ? up : (b->polarity < 0) ? down : (up < down) ? up : down;
+}
+
+// Recompute the cached bands for one key from its baseline, sensitivity and
+// actuation settings. Before calibration only the legacy absolute threshold
+// applies (press below it).
+static void update_key_band(uint8_t key_idx) {
+    key_band_t *b = &key_band[key_idx];
+    uint16_t base = key_baseline[key_idx] ? key_baseline[key_idx] : 512;
+
+    b->base = base;
+    b->polarity = key_polarity[key_idx];
+    b->bottom_out = key_bottom_out[key_idx] ? key_bottom_out[key_idx] : ANALOG_BOTTOM_OUT_DEFAULT;
+#if TEMP_COMPENSATION && TEMP_SENSITIVITY_PPM_PER_C
+    // Hall sensitivity follows temperature: scale the full-travel span
+    int32_t ppm = ((int32_t)TEMP_SENSITIVITY_PPM_PER_C * (temp_applied_x100 - temp_ref_x100)) / 100;
+    b->bottom_out = (uint16_t)(((int64_t)b->bottom_out * (1000000 + ppm)) / 1000000);
+    if (!b->bottom_out) b->bottom_out = 1;
+#endif
+    b->travel_scale = ((uint32_t)ANALOG_TRAVEL_FULL << 16) / b->bottom_out;
+    if (calibration_complete) {
+        uint32_t lower, upper;
+
+        if (key_sensitivity_sigma[key_idx] && key_noise_x16[key_idx]) {
+            // Deviation in multiples of this key's own noise
+            uint32_t dev = ((uint32_t)key_sensitivity_sigma[key_idx] * key_noise_x16[key_idx] + 15) / 16;
+            lower = (base > dev) ? base - dev : 0;
+            upper = base + dev;
+        } else {
+            uint8_t sens = key_sensitivity_percent[key_idx] ? key_sensitivity_percent[key_idx] : 10; // percent
+
+            // Lower and upper bounds based on percent deviation
+            lower = ((uint32_t)base * (100 - sens)) / 100;
+            upper = ((uint32_t)base * (100 + sens)) / 100;
+        }
+
+        // Safety clamps
+        if (lower < 1) lower = 1;
+        if (upper > 4095) upper = 4095;
+
+        b->press_lo = (uint16_t)lower;
+        b->press_hi = (uint16_t)upper;
+
+        // Release once back within KEY_RELEASE_PERCENT of the press deviation
+        b->release_lo = base - (uint16_t)(((uint32_t)(base - lower) * KEY_RELEASE_PERCENT) / 100);
+        b->release_hi = base + (uint16_t)(((uint32_t)(upper - base) * KEY_RELEASE_PERCENT) / 100);
+
+        // Trigger points on the linearized travel: millimetres if set,
+        // otherwise the first count past each band on the pressed side
+        if (key_actuation_mm_x100[key_idx]) {
+            b->press_depth = travel_from_mm_x100(key_actuation_mm_x100[key_idx]);
+            b->release_depth = key_reset_mm_x100[key_idx]
+                ? travel_from_mm_x100(key_reset_mm_x100[key_idx])
+                : (uint16_t)(((uint32_t)b->press_depth * KEY_RELEASE_PERCENT) / 100);
+            if (b->release_depth > b->press_depth) b->release_depth = b->press_depth;
+        } else {
+            b->press_depth = key_depth(key_idx, b, band_counts(b, b->press_lo, b->press_hi) + 1);
+            b->release_depth = key_depth(key_idx, b, band_counts(b, b->release_lo, b->release_hi) + 1);
+        }
+    } else {
+        b->press_lo = key_threshold[key_idx] ? key_threshold[key_idx] : SENSOR_THRESHOLD;
+        b->press_hi = 4095;
+
+        // No baseline yet, so no room for hysteresis
+        b->release_lo = b->press_lo;
+        b->release_hi = b->press_hi;
+    }
+}
+
+// Rapid trigger: past the actuation point the key follows its own
+// (linearized) travel instead of fixed points.
+// A pressed key releases once it rises release_delta above its deepest
+// point; a released key re-actuates once it sinks press_delta below its
+// shallowest. Plain mode leaves the zone at the actuation point, continuous
+// mode stays armed until the key is back above its release point.
+static bool rapid_trigger_should_press(key_rt_t *rt, const key_band_t *b, uint16_t travel, bool pressed) {
+    bool past_actuation = travel >= b->press_depth;
+    bool returned = travel < b->release_depth;
+    bool was_armed = rt->armed;
+
+    if (returned) {
+        rt->armed = false;
+    } else if (past_actuation) {
+        rt->armed = true;
+    } else if (rt->mode != RAPID_TRIGGER_CONTINUOUS) {
+        rt->armed = false;
+    }
+
+    if (!rt->armed) {
+        // Outside the zone: plain band hysteresis
+        return pressed ? !returned : past_actuation;
+    }
+    if (!was_armed) {
+        // Entering the zone is an actuation
+        return true;
+    }
+
+    if (pressed) {
+        if (travel > rt->extreme) rt->extreme = travel;
+        return (uint16_t)(rt->extreme - travel) < rt->release_delta;
+    }
+    if (travel < rt->extreme) rt->extreme = travel;
+    return (uint16_t)(travel - rt->extreme) >= rt->press_delta;
+}
+
+#if MUX_SCAN_OVERSAMPLE
+// Whether a key's travel is within MUX_OVERSAMPLE_MARGIN of the point its
+// next decision is made at: the band edge it would cross, or while rapid
+// trigger is armed, the delta from its extreme
+static bool travel_near_decision(uint8_t key_idx, const key_band_t *b, uint16_t travel) {
+    const key_rt_t *rt = &key_rt[key_idx];
+    int32_t point;
+
+    if (rt->mode != RAPID_TRIGGER_OFF && rt->armed) {
+        point = key_pressed[key_idx] ? (int32_t)rt->extreme - rt->release_delta : (int32_t)rt->extreme + rt->press_delta;
+    } else {
+        point = key_pressed[key_idx] ? b->release_depth : b->press_depth;
+    }
+    int32_t dist = (int32_t)travel - point;
+    return ((dist < 0) ? -dist : dist) < MUX_OVERSAMPLE_MARGIN;
+}
+#endif
+
+#if BASELINE_DRIFT_TRACKING
+// Follow slow (thermal) drift of resting values from the samples the scan
+// already took. Every BASELINE_DRIFT_PASSES passes, each released key whose
+// sample sits inside its release band feeds an integer IIR; the baseline
+// then steps at most one count toward the IIR output, never further than
+// BASELINE_DRIFT_MAX from calibration, and the cached bands follow.
+static void track_baseline_drift(const uint16_t frame[MAX_KEYS]) {
+    static uint16_t passes = 0;
+    if (++passes < BASELINE_DRIFT_PASSES) {
+        return;
+    }
+    passes = 0;
+
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        uint8_t key_idx = scan_plan[i].key_idx;
+        uint16_t adc_val = frame[key_idx];
+        const key_band_t *b = &key_band[key_idx];
+
+        // Only keys clearly at rest (guard band = release band)
+        if (key_pressed[key_idx] || adc_val < b->release_lo || adc_val > b->release_hi) {
+            continue;
+        }
+
+        uint32_t acc = key_baseline_acc[key_idx];
+        acc = acc - (acc >> BASELINE_DRIFT_SHIFT) + adc_val;
+        key_baseline_acc[key_idx] = acc;
+
+        uint16_t target = (acc + (1u << (BASELINE_DRIFT_SHIFT - 1))) >> BASELINE_DRIFT_SHIFT;
+        uint16_t base = key_baseline[key_idx];
+        uint16_t cal = key_baseline_cal[key_idx];
+        if (target > base && base < cal + BASELINE_DRIFT_MAX) {
+            key_baseline[key_idx] = base + 1;
+        } else if (target < base && base + BASELINE_DRIFT_MAX > cal) {
+            key_baseline[key_idx] = base - 1;
+        } else {
+            continue;
+        }
+        update_key_band(key_idx);
+    }
+}
+#endif
+
+#if TEMP_COMPENSATION
+// Average 16 conversions of the internal sensor (ADC input 4) and convert to
+// 0.01 degC: 0.706 V at 27 degC, -1.721 mV/degC (RP2040 datasheet). The
+// scan selects its own inputs again on every read.
+static int16_t read_temperature_x100(void) {
+    uint32_t sum = 0;
+    adc_select_input(4);
+    for (uint8_t i = 0; i < 16; i++) {
+        sum += adc_correct_dnl(adc_read());
+    }
+    adc_select_input(0);
+    int32_t uv = (int32_t)(((uint64_t)sum * 3300000u) / (16u * 4096u));
+    return (int16_t)(2700 - ((uv - 706000) * 100) / 1721);
+}
+
+// Move each key's baseline (and the drift tracker's anchor) to its offset
+// at temp_applied_x100, then rebuild its bands
+static void temperature_apply(void) {
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        uint8_t key_idx = scan_plan[i].key_idx;
+        int32_t dt = temp_applied_x100 - temp_ref_x100;
+        int16_t offset = (int16_t)(((int32_t)key_temp_coef_q8[key_idx] * dt) / (100 * 256));
+        int16_t delta = offset - key_temp_offset[key_idx];
+
+        if (!delta && !TEMP_SENSITIVITY_PPM_PER_C) {
+            continue;
+        }
+        key_temp_offset[key_idx] = offset;
+        key_baseline[key_idx] = (uint16_t)(key_baseline[key_idx] + delta);
+#if BASELINE_DRIFT_TRACKING
+        key_baseline_cal[key_idx] = (uint16_t)(key_baseline_cal[key_idx] + delta);
+        key_baseline_acc[key_idx] += (uint32_t)((int32_t)delta << BASELINE_DRIFT_SHIFT);
+#endif
+        update_key_band(key_idx);
+    }
+}
+
+// Add one warm-up sample, only while every key rests with a valid reading
+static void temp_learn_sample(const uint16_t frame[MAX_KEYS], int16_t t_x100) {
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        uint8_t key_idx = scan_plan[i].key_idx;
+        if (key_pressed[key_idx] || frame[key_idx] == 4095) {
+            return;
+        }
+    }
+    if (temp_fit.n == UINT16_MAX) {
+        return;
+    }
+    if (temp_fit.n == 0) {
+        temp_fit.t0 = temp_fit.t_min = temp_fit.t_max = t_x100;
+        memcpy(temp_fit_x0, frame, sizeof(temp_fit_x0));
+    }
+    if (t_x100 < temp_fit.t_min) temp_fit.t_min = t_x100;
+    if (t_x100 > temp_fit.t_max) temp_fit.t_max = t_x100;
+
+    int32_t t = t_x100 - temp_fit.t0;
+    temp_fit.n++;
+    temp_fit.sum_t += t;
+    temp_fit.sum_tt += (int64_t)t * t;
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        uint8_t key_idx = scan_plan[i].key_idx;
+        int32_t x = (int32_t)frame[key_idx] - temp_fit_x0[key_idx];
+        temp_fit_sum_x[key_idx] += x;
+        temp_fit_sum_tx[key_idx] += (int64_t)t * x;
+    }
+}
+
+// Fit each key's slope from the warm-up sums. The baselines (kept on the
+// actual rest values by the drift tracker meanwhile) become the reference
+// at the current temperature, and the drift tracker's anchor with them.
+// Scanner held.
+static void temp_learn_finish(void) {
+    int64_t n = temp_fit.n;
+    int64_t den = n * temp_fit.sum_tt - temp_fit.sum_t * temp_fit.sum_t;
+
+    temp_fit.n = 0;
+    if (n < TEMP_LEARN_MIN_SAMPLES || temp_fit.t_max - temp_fit.t_min < TEMP_LEARN_MIN_SPAN_X100 || den <= 0) {
+        return;
+    }
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        uint8_t key_idx = scan_plan[i].key_idx;
+        int64_t num = n * temp_fit_sum_tx[key_idx] - temp_fit.sum_t * temp_fit_sum_x[key_idx];
+        int64_t q8 = (num * 100 * 256) / den;  // counts per 0.01 degC -> per degC, Q8
+        key_temp_coef_q8[key_idx] = (int16_t)((q8 > INT16_MAX) ? INT16_MAX : (q8 < INT16_MIN) ? INT16_MIN : q8);
+        key_temp_offset[key_idx] = 0;
+#if BASELINE_DRIFT_TRACKING
+        key_baseline_cal[key_idx] = key_baseline[key_idx];
+        key_baseline_acc[key_idx] = (uint32_t)key_baseline[key_idx] << BASELINE_DRIFT_SHIFT;
+#endif
+    }
+    temp_ref_x100 = temp_applied_x100 = temp_now_x100;
+    for (uint8_t key_idx = 0; key_idx < MAX_KEYS; key_idx++) {
+        update_key_band(key_idx);
+    }
+}
+
+// Between passes: sample the temperature every TEMP_SAMPLE_MS, feed the
+// warm-up fit, and follow the temperature in steps of TEMP_STEP_X100
+static void temperature_tick(const uint16_t frame[MAX_KEYS]) {
+    uint32_t now = time_us_32();
+    if ((now - temp_last_us) < TEMP_SAMPLE_MS * 1000u) {
+        return;
+    }
+    temp_last_us = now;
+
+    int16_t t = read_temperature_x100();
+    temp_now_x100 = (int16_t)(temp_now_x100 + (t - temp_now_x100) / 4);
+    if (!calibration_complete) {
+        return;
+    }
+
+    if (temp_learning) {
+        temp_learn_sample(frame, temp_now_x100);
+        return;  // compensation waits until the new slopes are in
+    }
+
+    int32_t moved = temp_now_x100 - temp_applied_x100;
+    if (moved > -TEMP_STEP_X100 && moved < TEMP_STEP_X100) {
+        return;
+    }
+    temp_applied_x100 = temp_now_x100;
+    temperature_apply();
+}
+#endif
+
+#if MUX_SCAN_PARALLEL
+// Start of each address group in the (address-major) plan, in plan order
+static void init_scan_order(void) {
+    scan_order_len = 0;
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        if (i == 0 || scan_plan[i].channel != scan_plan[i - 1].channel) {
+            scan_order[scan_order_len++] = i;
+        }
+    }
+}
+#endif
+
+#if MUX_SCAN_ORDER_OPTIMIZE
+// Settling time grows with the voltage step between consecutive addresses,
+// and all three muxes switch together, so a step costs the largest change on
+// any of the three outputs.
+static uint16_t address_step(const uint16_t a[3], const uint16_t b[3]) {
+    uint16_t worst = 0;
+    for (uint8_t m = 0; m < 3; m++) {
+        uint16_t d = (a[m] > b[m]) ? a[m] - b[m] : b[m] - a[m];
+        if (d > worst) {
+            worst = d;
+        }
+    }
+    return worst;
+}
+
+static uint32_t scan_order_cost(const uint16_t level[32][3]) {
+    uint32_t cost = 0;
+    for (uint8_t o = 0; o < scan_order_len; o++) {
+        uint8_t next = (o + 1 < scan_order_len) ? o + 1 : 0;  // passes wrap around
+        cost += address_step(level[scan_plan[scan_order[o]].channel], level[scan_plan[scan_order[next]].channel]);
+    }
+    return cost;
+}
+
+// Reorder the parallel scan so consecutive addresses sit at similar resting
+// levels: sample every address fully settled, build a nearest-neighbour
+// tour over the levels, then improve it with 2-opt. The tour is cyclic since
+// each pass starts where the previous one ended. At most 32 addresses, so
+// this costs a few milliseconds at boot.
+static void optimize_scan_order(void) {
+    static uint16_t level[32][3];
+
+    init_scan_order();
+    mux_cs_select(MUX_CS_ALL);
+    for (uint8_t o = 0; o < scan_order_len; o++) {
+        uint8_t ch = scan_plan[scan_order[o]].channel;
+        select_mux_channel(ch);
+        scan_wait_us(MUX_SETTLE_US);
+        read_adc_round_robin(level[ch]);
+    }
+    mux_cs_release();
+
+    uint32_t plan_cost = scan_order_cost(level);
+
+    // Nearest neighbour from the first address
+    for (uint8_t o = 1; o < scan_order_len; o++) {
+        const uint16_t *from = level[scan_plan[scan_order[o - 1]].channel];
+        uint8_t best = o;
+        for (uint8_t j = o + 1; j < scan_order_len; j++) {
+            if (address_step(from, level[scan_plan[scan_order[j]].channel]) <
+                address_step(from, level[scan_plan[scan_order[best]].channel])) {
+                best = j;
+            }
+        }
+        uint8_t t = scan_order[o];
+        scan_order[o] = scan_order[best];
+        scan_order[best] = t;
+    }
+
+    // 2-opt: reverse order[i..j] while that shortens the cycle
+    bool improved = true;
+    while (improved) {
+        improved = false;
+        for (uint8_t i = 1; i + 1 < scan_order_len; i++) {
+            for (uint8_t j = i + 1; j < scan_order_len; j++) {
+                const uint16_t *a = level[scan_plan[scan_order[i - 1]].channel];
+                const uint16_t *b = level[scan_plan[scan_order[i]].channel];
+                const uint16_t *c = level[scan_plan[scan_order[j]].channel];
+                const uint16_t *d = level[scan_plan[scan_order[(j + 1 < scan_order_len) ? j + 1 : 0]].channel];
+                if (address_step(a, c) + address_step(b, d) < address_step(a, b) + address_step(c, d)) {
+                    for (uint8_t l = i, r = j; l < r; l++, r--) {
+                        uint8_t t = scan_order[l];
+                        scan_order[l] = scan_order[r];
+                        scan_order[r] = t;
+                    }
+                    improved = true;
+                }
+            }
+        }
+    }
+
+    char msg[64];
+    snprintf(msg, sizeof(msg), "[order] step sum %lu -> %lu counts\n", (unsigned long)plan_cost, (unsigned long)scan_order_cost(level));
+    uart_send_string(msg);
+}
+#endif
+
+#if MUX_SETTLE_ADAPTIVE
+// A press can move any input across the whole ADC range, so the budget is
+// sized for a full-scale step, not the resting step that was measured
+#define SETTLE_FULL_STEP (4095u >> MUX_ADC_RESULT_SHIFT)
+// Smallest measured step (counts) a settle time is scaled up from
+#define SETTLE_FIT_MIN_STEP (8 * MUX_SETTLE_TOLERANCE)
+
+// log2(x) in 1/16ths for 1 <= x < 2^27, interpolated between powers of two
+// (reads low by less than 0.09)
+static uint16_t log2_x16(uint32_t x) {
+    uint8_t n = (uint8_t)(31 - __builtin_clz(x));
+    return (uint16_t)(n * 16 + ((x << 4) >> n) - 16);
+}
+
+// Settle time of an input over a full-scale step, from `us` taken to come
+// within MUX_SETTLE_TOLERANCE of a `step` count one. An RC output is within
+// tolerance after tau * ln(step / tolerance), so the time scales with the
+// log of the step.
+static uint32_t settle_full_step_us(uint32_t us, uint16_t step) {
+    uint32_t full = log2_x16(SETTLE_FULL_STEP / MUX_SETTLE_TOLERANCE);
+    uint32_t measured = log2_x16(step / MUX_SETTLE_TOLERANCE);
+    return (us * full + measured - 1) / measured;
+}
+
+// Measure how long each address takes to settle: latch the address whose
+// resting levels differ most from this one's and let it settle fully, latch
+// this one, then sample all three outputs back to back for MUX_SETTLE_US.
+// Per output, the settle time is that of the first sample from which every
+// later one stays within MUX_SETTLE_TOLERANCE of the final reading, scaled
+// from the step seen to a full-scale one (settle_full_step_us); the worst of
+// a few runs plus MUX_SETTLE_MARGIN_US is the budget. An address whose steps
+// are all too small to scale from takes the worst budget measured on the
+// board, or MUX_SETTLE_US when none could be.
+static void measure_settle_times(void) {
+    enum { RUNS = 3, MAX_SAMPLES = 64 };
+    static uint16_t rest[32][3];
+    static uint16_t trace[MAX_SAMPLES][3];
+    static uint16_t trace_us[MAX_SAMPLES];
+    uint16_t board_worst = 0;
+    uint32_t total = 0;
+
+    mux_cs_select(MUX_CS_ALL);
+    for (uint8_t o = 0; o < scan_order_len; o++) {
+        uint8_t ch = scan_plan[scan_order[o]].channel;
+        select_mux_channel(ch);
+        scan_wait_us(MUX_SETTLE_US);
+        read_adc_round_robin(rest[ch]);
+    }
+
+    for (uint8_t o = 0; o < scan_order_len; o++) {
+        uint8_t ch = scan_plan[scan_order[o]].channel;
+        uint8_t prev = ch;
+        uint16_t widest = 0;
+        uint32_t budget = 0;
+
+        for (uint8_t p = 0; p < scan_order_len; p++) {
+            uint8_t other = scan_plan[scan_order[p]].channel;
+            for (uint8_t m = 0; m < 3; m++) {
+                uint16_t d = (rest[other][m] > rest[ch][m]) ? rest[other][m] - rest[ch][m] : rest[ch][m] - rest[other][m];
+                if (d > widest) {
+                    widest = d;
+                    prev = other;
+                }
+            }
+        }
+
+        for (uint8_t run = 0; run < RUNS; run++) {
+            uint16_t before[3];
+            select_mux_channel(prev);
+            scan_wait_us(MUX_SETTLE_US);
+            read_adc_round_robin(before);
+
+            select_mux_channel(ch);
+            uint32_t start = time_us_32();
+            uint8_t n = 0;
+            uint32_t elapsed;
+            while ((elapsed = time_us_32() - start) < MUX_SETTLE_US && n < MAX_SAMPLES) {
+                trace_us[n] = (uint16_t)elapsed;
+                read_adc_round_robin(trace[n]);
+                n++;
+            }
+            uint16_t final[3];
+            read_adc_round_robin(final);
+
+            for (uint8_t m = 0; m < 3; m++) {
+                uint16_t step = (before[m] > final[m]) ? before[m] - final[m] : final[m] - before[m];
+                if (step < SETTLE_FIT_MIN_STEP) {
+                    continue;
+                }
+                // Walk back to the last sample still outside the tolerance
+                uint32_t settled = 0;
+                for (uint8_t k = n; k-- > 0;) {
+                    uint16_t d = (trace[k][m] > final[m]) ? trace[k][m] - final[m] : final[m] - trace[k][m];
+                    if (d > MUX_SETTLE_TOLERANCE) {
+                        settled = (k + 1 < n) ? trace_us[k + 1] : MUX_SETTLE_US;
+                        break;
+                    }
+                }
+                uint32_t full = settle_full_step_us(settled, step) + MUX_SETTLE_MARGIN_US;
+                if (full > budget) {
+                    budget = full;
+                }
+            }
+        }
+
+        // 0 = nothing to scale from yet
+        address_settle_us[ch] = (uint16_t)((budget > MUX_SETTLE_US) ? MUX_SETTLE_US : budget);
+        if (address_settle_us[ch] > board_worst) {
+            board_worst = address_settle_us[ch];
+        }
+    }
+    mux_cs_release();
+
+    for (uint8_t o = 0; o < scan_order_len; o++) {
+        uint8_t ch = scan_plan[scan_order[o]].channel;
+        if (!address_settle_us[ch]) {
+            address_settle_us[ch] = board_worst ? board_worst : MUX_SETTLE_US;
+        }
+        if (address_settle_us[ch] < MUX_SETTLE_MIN_US) {
+            address_settle_us[ch] = MUX_SETTLE_MIN_US;
+        }
+        total += address_settle_us[ch];
+    }
+
+    char msg[64];
+    snprintf(msg, sizeof(msg), "[settle] %lu us per pass (fixed: %u us)\n", (unsigned long)total, 32u * MUX_SETTLE_US);
+    uart_send_string(msg);
+}
+#endif
+
+#if KEY_PREDICTIVE_ACTUATION
+// Fold one sample into the key's tracker (fixed gains: alpha 1/2, beta 1/8)
+static inline void track_travel(key_track_t *t, uint16_t travel) {
+    int32_t predicted = t->x + t->v;
+    int32_t residual = ((int32_t)travel << PREDICT_FRAC_BITS) - predicted;
+    t->x = predicted + (residual >> 1);
+    t->v += residual >> 3;
+}
+
+// Press early if the key is moving down fast enough to cross its actuation
+// point before its next sample. Extrapolates from the sample itself: the
+// tracker's position lags a key that is still speeding up. Only past the
+// release point, so a predicted press is held by the normal hysteresis.
+static inline bool predict_press(const key_track_t *t, const key_band_t *b, uint16_t travel) {
+    if (!predict_lead_percent || travel < b->release_depth) return false;
+    if (t->v < (PREDICT_MIN_SPEED << PREDICT_FRAC_BITS)) return false;
+
+    int32_t ahead = ((int32_t)travel << PREDICT_FRAC_BITS) + t->v * predict_lead_percent / 100;
+    return (ahead >> PREDICT_FRAC_BITS) >= b->press_depth;
+}
+#endif
+
+#if CROSSTALK_COMPENSATION
+// Turn the sums gathered for the key that was held into its coefficients:
+// the CROSSTALK_NEIGHBORS keys it moved furthest, if the mean shift stands
+// clear of their own noise (3 sigma, and at least one count)
+static void crosstalk_finish_source(void) {
+    uint8_t src = crosstalk_source;
+    crosstalk_source = CROSSTALK_NO_SOURCE;
+    if (src == CROSSTALK_NO_SOURCE || crosstalk_passes < CROSSTALK_MIN_PASSES || crosstalk_sum[src] == 0) {
+        return;
+    }
+
+    uint8_t target[CROSSTALK_NEIGHBORS] = {0};
+    uint32_t shift_x16[CROSSTALK_NEIGHBORS] = {0};
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        uint8_t key_idx = scan_plan[i].key_idx;
+        int32_t sum = crosstalk_sum[key_idx];
+        uint32_t mean_x16 = ((uint32_t)(sum < 0 ? -sum : sum) * 16) / crosstalk_passes;
+        if (key_idx == src || mean_x16 < 16 || mean_x16 < 3u * key_noise_x16[key_idx]) {
+            continue;
+        }
+        // Replace the weakest kept neighbour
+        uint8_t weakest = 0;
+        for (uint8_t n = 1; n < CROSSTALK_NEIGHBORS; n++) {
+            if (shift_x16[n] < shift_x16[weakest]) weakest = n;
+        }
+        if (mean_x16 > shift_x16[weakest]) {
+            shift_x16[weakest] = mean_x16;
+            target[weakest] = key_idx;
+        }
+    }
+
+    for (uint8_t n = 0; n < CROSSTALK_NEIGHBORS; n++) {
+        int32_t coef = 0;
+        if (shift_x16[n]) {
+            int64_t q12 = ((int64_t)crosstalk_sum[target[n]] * 4096) / crosstalk_sum[src];
+            coef = (q12 > INT16_MAX) ? INT16_MAX : (q12 < INT16_MIN) ? INT16_MIN : (int32_t)q12;
+        }
+        key_crosstalk_target[src][n] = target[n];
+        key_crosstalk_coef[src][n] = (int16_t)coef;
+    }
+}
+
+// One capture pass (raw samples): while exactly one key is held past half
+// its bottom-out travel, add every key's offset from rest to its sums.
+// Releasing it, or holding another key alone, finishes it.
+static void crosstalk_capture_frame(const uint16_t frame[MAX_KEYS]) {
+    uint8_t held = CROSSTALK_NO_SOURCE;
+    uint8_t held_count = 0;
+
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        uint8_t key_idx = scan_plan[i].key_idx;
+        const key_band_t *b = &key_band[key_idx];
+        if (frame[key_idx] == 4095) {
+            return;  // a pass with a gap would skew every sum
+        }
+        if (key_travel(b, frame[key_idx]) >= b->bottom_out / 2) {
+            held = key_idx;
+            held_count++;
+        }
+    }
+    if (held_count > 1) {
+        return;  // chords cannot be separated
+    }
+    if (held != crosstalk_source) {
+        crosstalk_finish_source();
+        if (held == CROSSTALK_NO_SOURCE) {
+            return;
+        }
+        crosstalk_source = held;
+        crosstalk_passes = 0;
+        memset(crosstalk_sum, 0, sizeof(crosstalk_sum));
+    }
+    if (crosstalk_passes == UINT16_MAX) {
+        return;
+    }
+    crosstalk_passes++;
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        uint8_t key_idx = scan_plan[i].key_idx;
+        crosstalk_sum[key_idx] += (int32_t)frame[key_idx] - key_baseline[key_idx];
+    }
+}
+#endif
+
+// Evaluate one sampled frame: update per-key state and build the matrix.
+// Hall sensors do not bounce, so there is no timer: the bands' hysteresis
+// rejects noise and a transition lands on the sample that crosses (or the
+// KEY_CONFIRM_SAMPLES-th one in a row, if configured higher).
+static bool evaluate_frame(matrix_row_t matrix[], const uint16_t frame[MAX_KEYS]) {
+    bool changed = false;
+    uint32_t now_us = time_us_32();
+    analog_frame_t *analog = analog_matrix_back_buffer();
+
+    // Clear matrix output
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        matrix[row] = 0;
+    }
+
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        const scan_plan_entry_t *e = &scan_plan[i];
+        uint8_t key_idx = e->key_idx;
+        uint16_t adc_val = frame[key_idx];
+        const key_band_t *b = &key_band[key_idx];
+
+        // Distance from rest (4095 = invalid sample, no travel)
+        // and its linearized travel
+        uint16_t counts = (adc_val == 4095) ? 0 : key_travel(b, adc_val);
+        uint16_t travel = key_depth(key_idx, b, counts);
+
+#if KEY_PREDICTIVE_ACTUATION
+        if (KEY_SAMPLED(key_idx)) {
+            track_travel(&key_track[key_idx], travel);
+        }
+#endif
+
+        bool should_press;
+        if (adc_val == 4095) {
+            // An invalid sample says nothing about the key: keep its state
+            should_press = key_pressed[key_idx];
+        } else if (!calibration_complete) {
+            // No baseline yet: legacy absolute threshold
+            should_press = adc_val < b->press_lo;
+        } else if (key_rt[key_idx].mode != RAPID_TRIGGER_OFF) {
+            should_press = rapid_trigger_should_press(&key_rt[key_idx], b, travel, key_pressed[key_idx]);
+        } else if (key_pressed[key_idx]) {
+            should_press = travel >= b->release_depth;
+        } else {
+            should_press = travel >= b->press_depth;
+#if KEY_PREDICTIVE_ACTUATION
+            if (!should_press && KEY_SAMPLED(key_idx)) {
+                should_press = predict_press(&key_track[key_idx], b, travel);
+            }
+#endif
+        }
+
+        if (!KEY_SAMPLED(key_idx)) {
+            // Cold key not sampled this pass: hold its state and confirm count
+        } else if (should_press != key_pressed[key_idx]) {
+            if (++key_confirm[key_idx] >= KEY_CONFIRM_SAMPLES) {
+                key_pressed[key_idx] = should_press;
+                key_confirm[key_idx] = 0;
+                // Rapid trigger measures the next move from where this one landed
+                key_rt[key_idx].extreme = travel;
+                changed = true;
+                scan_window.changes++;
+#if KEY_PREDICTIVE_ACTUATION
+                // A static press below the actuation point was predicted;
+                // releasing before it gets there makes it a false actuation
+                if (should_press && calibration_complete && key_rt[key_idx].mode == RAPID_TRIGGER_OFF && travel < b->press_depth) {
+                    key_predicted[key_idx] = true;
+                    scan_window.predicted++;
+                } else if (!should_press && key_predicted[key_idx]) {
+                    key_predicted[key_idx] = false;
+                    scan_window.predict_false++;
+                }
+#endif
+                // Stamp the change with the sample that committed it and the
+                // snapshot this pass will publish (core1 is its only writer);
+                // core0 replays core1's changes in order (matrix_scan_custom)
+#if MUX_SCAN_CORE1
+                if (core1_running()) {
+                    key_events_push(key_sample_us[key_idx], scan_snapshot.seq + 2, key_idx, should_press);
+                } else
+#endif
+                {
+                    key_change_us[key_idx] = key_sample_us[key_idx];
+                }
+            }
+        } else {
+            key_confirm[key_idx] = 0;
+        }
+
+#if KEY_PREDICTIVE_ACTUATION
+        if (key_predicted[key_idx] && key_pressed[key_idx] && travel >= b->press_depth) {
+            key_predicted[key_idx] = false;  // the prediction came true
+        }
+#endif
+
+        if (key_pressed[key_idx]) {
+            matrix[e->row] |= e->col_bit;
+        }
+
+#if MUX_SCAN_OVERSAMPLE
+        if (KEY_SAMPLED(key_idx)) {
+            key_near_decision[key_idx] = calibration_complete && adc_val != 4095 && travel_near_decision(key_idx, b, travel);
+        }
+#endif
+
+        analog->travel[key_idx] = travel;
+        if (bottom_out_capture && adc_val != 4095) {
+            if (adc_val < key_capture_min[key_idx]) key_capture_min[key_idx] = adc_val;
+            if (adc_val > key_capture_max[key_idx]) key_capture_max[key_idx] = adc_val;
+        }
+    }
+
+    memcpy(analog->pressed, matrix, sizeof(analog->pressed));
+    analog->time_us = now_us;
+    analog_matrix_publish();
+
+#if BASELINE_DRIFT_TRACKING
+    if (calibration_complete) {
+        track_baseline_drift(frame);
+    }
+#endif
+
+#if CROSSTALK_COMPENSATION
+    if (crosstalk_capture) {
+        crosstalk_capture_frame(frame);
+    } else if (crosstalk_source != CROSSTALK_NO_SOURCE) {
+        crosstalk_finish_source();  // the key held when the capture stopped
+    }
+#endif
+
+    return changed;
+}
+
+static inline uint16_t sat16(uint32_t v) {
+    return (v > 0xFFFF) ? 0xFFFF : (uint16_t)v;
+}
+
+// Count one finished pass of pass_us; every second the window becomes the
+// published stats and starts over
+static void scan_stats_tick(uint32_t pass_us) {
+    uint32_t now = time_us_32();
+
+    if (scan_window.passes == 0 || pass_us < scan_window.pass_us_min) scan_window.pass_us_min = pass_us;
+    if (pass_us > scan_window.pass_us_max) scan_window.pass_us_max = pass_us;
+    scan_window.pass_us_sum += pass_us;
+    scan_window.passes++;
+
+    if ((now - scan_window.start_us) < 1000000) {
+        return;
+    }
+
+    uint32_t seq = scan_stats_seq;
+    scan_stats_seq = seq + 1;  // odd: update in progress
+    __dmb();
+    scan_stats = (mux_scan_stats_t){
+        .passes_per_s    = scan_window.passes,
+        .pass_us_min     = sat16(scan_window.pass_us_min),
+        .pass_us_avg     = sat16(scan_window.pass_us_sum / scan_window.passes),
+        .pass_us_max     = sat16(scan_window.pass_us_max),
+        .settle_us_per_s = scan_window.settle_us,
+        .adc_us_per_s    = scan_window.adc_us,
+        .invalid_per_s   = sat16(scan_window.invalid),
+        .spikes_per_s    = sat16(scan_window.spikes),
+        .changes_per_s   = sat16(scan_window.changes),
+        .predicted_per_s = sat16(scan_window.predicted),
+        .predict_false_per_s = sat16(scan_window.predict_false),
+        .oversampled_per_s = sat16(scan_window.oversampled),
+    };
+#if MUX_SCAN_OVERSAMPLE
+    memcpy(key_oversample_rate, key_oversamples, sizeof(key_oversample_rate));
+    memset(key_oversamples, 0, sizeof(key_oversamples));
+#endif
+    __dmb();
+    scan_stats_seq = seq + 2;
+
+    memset(&scan_window, 0, sizeof(scan_window));
+    scan_window.start_us = now;
+}
+
+// Current USB frame number (11 bits), bumped by the controller at every SOF
+static inline uint16_t usb_frame_number(void) {
+    return *(io_ro_32 *)(USBCTRL_REGS_BASE + USB_SOF_RD_OFFSET) & USB_SOF_RD_BITS;
+}
+
+// Decide whether the inline scan should run now. Passes are started so they
+// end SCAN_GOVERNOR_GUARD_US before the next start-of-frame, so the report
+// QMK builds right after carries a sample taken within the same frame. SOF
+// is seen by polling the frame number, so sightings are late by up to one
+// main-loop iteration; the estimate keeps the earliest sighting and only
+// creeps later by 1 us per frame to follow host clock drift.
+static bool scan_governor_due(uint32_t now_us) {
+    uint16_t frame = usb_frame_number();
+
+    if (frame != sof_frame) {
+        uint16_t frames = (frame - sof_frame) & USB_SOF_RD_BITS;
+        uint32_t predicted = sof_time_us + (uint32_t)frames * USB_FRAME_US;
+        int32_t late = (int32_t)(now_us - predicted);
+
+        if (late < 0 || late > USB_FRAME_US) {
+            sof_time_us = now_us;  // earlier sighting, or lost track
+        } else {
+            sof_time_us = predicted + (late ? 1 : 0);
+        }
+        sof_frame = frame;
+    }
+
+    // No SOF for a while (not enumerated / suspended): free-run
+    if ((now_us - sof_time_us) > 2 * USB_FRAME_US) {
+        return true;
+    }
+    // A pass that cannot fit in a frame runs back to back
+    if (scan_pass_us + SCAN_GOVERNOR_GUARD_US >= USB_FRAME_US) {
+        return true;
+    }
+    // Otherwise one pass per frame, as late as it can start
+    if (frame == scanned_frame) {
+        return false;
+    }
+    return (now_us - sof_time_us) >= USB_FRAME_US - SCAN_GOVERNOR_GUARD_US - scan_pass_us;
+}
 
-// ESP_RESET_PIN definition (GP3 - bootloader trigger pin, must be HIGH during boot)
-#ifndef ESP_RESET_PIN
-#define ESP_RESET_PIN GP3
-#endif
+// Copy the latest consistent snapshot (reader side, core0). Returns the
+// sequence number that was copied so callers can tell if it is new.
+static uint32_t snapshot_read(matrix_row_t matrix[], uint16_t frame[MAX_KEYS]) {
+    uint32_t seq_begin, seq_end;
+    do {
+        seq_begin = scan_snapshot.seq;
+        __dmb();
+        memcpy(matrix, scan_snapshot.matrix, sizeof(scan_snapshot.matrix));
+        memcpy(frame, scan_snapshot.frame, sizeof(scan_snapshot.frame));
+        __dmb();
+        seq_end = scan_snapshot.seq;
+    } while ((seq_begin & 1) || seq_begin != seq_end);
+    return seq_end;
+}
 
-// ADC debug output buffer (for formatting display)
-static uint16_t adc_values[90];  // Store all ADC values for display
-static uint32_t last_adc_print_time = 0;
-#define ADC_PRINT_INTERVAL_MS 1000  // Print every 1000ms (1 second)
+// Wait for the core1 scanner to publish a pass newer than the one we saw
+static void snapshot_wait_frame(uint16_t frame[MAX_KEYS]) {
+    static matrix_row_t discard[MATRIX_ROWS];
+    uint32_t seen = scan_snapshot.seq | 1;
+    while (snapshot_read(discard, frame) <= seen) {
+    }
+}
 
-// NOTE: On this board the ADG732 EN pins are grounded (always enabled).
-// We therefore select each ADG732 using its CS pin (active low) and latch
-// addresses with the WR pin. If you have external EN pins, you can enable
-// them by defining MUX1_EN / MUX2_EN / MUX3_EN in your board config.
+// Changes core0 makes to state the scanner uses during a pass (bands,
+// baselines, travel curves, rapid trigger) happen with core1 parked between
+// passes, so a pass never sees half an update and the scanner's own writers
+// (drift tracking, temperature) cannot interleave with them. Costs core0 at
+// most one pass; a no-op while core0 scans inline.
+static inline void scanner_hold(void) {
+    core1_park_begin();
+}
 
-// Key state tracking for 81 keys (6 rows × 15 cols max)
-// Using MATRIX_ROWS * MATRIX_COLS = 6 * 15 = 90 slots to be safe
-#define MAX_KEYS (MATRIX_ROWS * MATRIX_COLS)
-static bool key_pressed[MAX_KEYS];
-static uint32_t key_timer[MAX_KEYS];
+static inline void scanner_release(void) {
+    core1_park_end();
+}
 
-// Auto-calibration storage
-static uint16_t key_baseline[MAX_KEYS];      // Baseline (resting) ADC value for each key
-static uint16_t key_threshold[MAX_KEYS];     // (legacy) absolute threshold - kept for compatibility
-static uint8_t key_sensitivity_percent[MAX_KEYS]; // Sensitivity percent per key (deviation percent)
-static bool calibration_complete = false;    // Flag indicating calibration status
+#if MUX_SCAN_CORE1
+// Publish the latest matrix and raw frame (writer side, core1 only)
+static void snapshot_publish(const matrix_row_t matrix[], const uint16_t frame[MAX_KEYS]) {
+    uint32_t seq = scan_snapshot.seq;
+    scan_snapshot.seq = seq + 1;  // odd: update in progress
+    __dmb();
+    memcpy(scan_snapshot.matrix, matrix, sizeof(scan_snapshot.matrix));
+    memcpy(scan_snapshot.frame, frame, sizeof(scan_snapshot.frame));
+    __dmb();
+    scan_snapshot.seq = seq + 2;  // even: consistent
+}
 
-// Debug counter to limit output
-// Debug counters (may be used later); mark volatile to avoid unused warnings
-static volatile uint32_t debug_counter = 0;
-static volatile uint32_t last_debug_time = 0;
+#if MUX_SCAN_PERIOD_US
+// Sleep until the hardware timer reaches deadline. The alarm's interrupt is
+// enabled at the timer but in neither NVIC, so it only goes pending; with
+// SEVONPEND set that wakes core1's WFE without a handler in ChibiOS's vector
+// table. Returns at once if the deadline has already passed.
+static void scan_alarm_wait(uint32_t deadline) {
+    const uint32_t mask = 1u << SCAN_ALARM_NUM;  // TIMER_IRQ_n is IRQ n
+    io_rw_32 *nvic_icpr = (io_rw_32 *)(PPB_BASE + M0PLUS_NVIC_ICPR_OFFSET);
 
-// Helper for reading ADC
-// Helper for reading ADC (kept static but may be unused in diagnostic stub)
-static inline uint16_t read_adc_pin(pin_t pin) {
-    return analogReadPin(pin);
+    timer_hw->alarm[SCAN_ALARM_NUM] = deadline;
+    // The alarm matches the exact count: if that already went by, disarm
+    if ((int32_t)(deadline - time_us_32()) <= 0) {
+        timer_hw->armed = mask;
+    } else {
+        while (!(timer_hw->intr & mask)) {
+            __wfe();
+        }
+    }
+    timer_hw->intr = mask;
+    *nvic_icpr = mask;  // so the next alarm is a new pending edge
 }
+#endif
 
-// Helper for selecting MUX channel
-// Helper to select MUX channel (kept inline to avoid unused-function error)
-static inline void select_mux_channel(uint8_t channel) {
-    // Set address lines (A0..A4)
-    writePin(MUX_A0, (channel & 0x01) ? 1 : 0);
-    writePin(MUX_A1, (channel & 0x02) ? 1 : 0);
-    writePin(MUX_A2, (channel & 0x04) ? 1 : 0);
-    writePin(MUX_A3, (channel & 0x08) ? 1 : 0);
-    writePin(MUX_A4, (channel & 0x10) ? 1 : 0);
+// Core1 entry: scan continuously and publish every pass. With
+// MUX_SCAN_PERIOD_US each pass starts on a hardware alarm at a fixed rate.
+static void scan_core1_main(void) {
+    static uint16_t frame[MAX_KEYS];
+    static matrix_row_t matrix[MATRIX_ROWS];
 
-    // Pulse WR low to latch the address into the ADG732 (falling edge triggers latch)
-#ifdef MUX_WR
-    writePinLow(MUX_WR);
-    wait_us(5); // short pulse to ensure latch
-    writePinHigh(MUX_WR);
-#else
-    // If no WR pin is defined, give address lines time to settle
-    wait_us(50);
+#if MUX_SCAN_PERIOD_US
+    scb_hw->scr |= M0PLUS_SCR_SEVONPEND_BITS;
+    hw_set_bits(&timer_hw->inte, 1u << SCAN_ALARM_NUM);
+    uint32_t deadline = time_us_32();
+#endif
+
+    while (true) {
+#if MUX_SCAN_PERIOD_US
+        // An overrun starts the next pass at once and restarts the cadence
+        deadline += MUX_SCAN_PERIOD_US;
+        if ((int32_t)(deadline - time_us_32()) <= 0) {
+            deadline = time_us_32();
+        }
+        scan_alarm_wait(deadline);
 #endif
+        uint32_t start_us = time_us_32();
+        scan_mux_frame(frame);
+        evaluate_frame(matrix, frame);
+        snapshot_publish(matrix, frame);
+        scan_stats_tick(time_us_32() - start_us);
+#if TEMP_COMPENSATION
+        temperature_tick(frame);
+#endif
+        core1_park_point();  // stand still while core0 writes flash or config
+    }
+}
+#endif
+
+// Print the last frame as a keyboard-shaped ADC table over UART
+static void print_adc_table(void) {
+    const uint16_t *adc_values = adc_frame;
+
+    // Build entire display in one giant buffer matching zuart.txt format exactly
+    static char adc_display[1200];
+    int pos = 0;
+    
+    // Row 0: F-keys (14 positions, using indices 0-11,12,13 skipping 11 for F11)
+    pos += snprintf(adc_display + pos, sizeof(adc_display) - pos, 
+                   "|Esc:   %04d |F1:  %04d |F2    %04d |F3:  %04d |F4:   %04d |F5: %04d |F6: %04d |F7: %04d |F8: %04d |F9: %04d |F10: %04d |F12:   %04d |Del: %04d |\n",
+                   adc_values[0], adc_values[1], adc_values[2], adc_values[3], adc_values[4], adc_values[5], 
+                   adc_values[6], adc_values[7], adc_values[8], adc_values[9], adc_values[10], adc_values[12], adc_values[13]);
+    
+    // Row 1: Number row (15 positions, indices 15-29)
+    pos += snprintf(adc_display + pos, sizeof(adc_display) - pos,
+                   "|`:     %04d |1:   %04d |2:    %04d |3:   %04d |4:    %04d |5:  %04d |6:  %04d |7:  %04d |8:  %04d |9:  %04d |0:   %04d |-:     %04d |=:   %04d |Back: %04d |\n",
+                   adc_values[15], adc_values[16], adc_values[17], adc_values[18], adc_values[19], adc_values[20], 
+                   adc_values[21], adc_values[22], adc_values[23], adc_values[24], adc_values[25], adc_values[26], adc_values[27], adc_values[28]);
+    
+    // Row 2: QWERTY row (15 positions, indices 30-44)
+    pos += snprintf(adc_display + pos, sizeof(adc_display) - pos,
+                   "|Tab:   %04d |Q:   %04d |W:    %04d |E:   %04d |R:    %04d |T:  %04d |Y:  %04d |U:  %04d |I:  %04d |O:  %04d |P:   %04d |[:     %04d |]:   %04d |Home: %04d |\n",
+                   adc_values[30], adc_values[31], adc_values[32], adc_values[33], adc_values[34], adc_values[35], 
+                   adc_values[36], adc_values[37], adc_values[38], adc_values[39], adc_values[40], adc_values[41], adc_values[42], adc_values[44]);
+    
+    // Row 3: ASDF row (14 positions, indices 45-58)
+    pos += snprintf(adc_display + pos, sizeof(adc_display) - pos,
+                   "|Caps:  %04d |A:   %04d |S:    %04d |D:   %04d |F:    %04d |G:  %04d |H:  %04d |J:  %04d |K:  %04d |L:  %04d |;:   %04d |':     %04d |Ent: %04d |PgUp: %04d |\n",
+                   adc_values[45], adc_values[46], adc_values[47], adc_values[48], adc_values[49], adc_values[50], 
+                   adc_values[51], adc_values[52], adc_values[53], adc_values[54], adc_values[55], adc_values[56], adc_values[57], adc_values[58]);
+    
+    // Row 4: ZXCV row (13 positions, indices 60-72 with padding)
+    pos += snprintf(adc_display + pos, sizeof(adc_display) - pos,
+                   "|LShft: %04d |Z:   %04d |X:    %04d |C:   %04d |V:    %04d |B:  %04d |N:  %04d |M:  %04d |,:  %04d |.:  %04d |/:   %04d |RShft: %04d |↑:   %04d |\n",
+                   adc_values[60], adc_values[61], adc_values[62], adc_values[63], adc_values[64], adc_values[65], 
+                   adc_values[66], adc_values[67], adc_values[68], adc_values[69], adc_values[70], adc_values[71], adc_values[72]);
+    
+    // Row 5: Bottom row (10 positions, indices 75-84 with padding)
+    pos += snprintf(adc_display + pos, sizeof(adc_display) - pos,
+                   "|Ctrl:  %04d |Win: %04d |RAlt: %04d |                      Spc: %04d                     |Alt:%04d |Fn: %04d |          |←:     %04d |↓:   %04d |→:    %04d |\n\n",
+                   adc_values[75], adc_values[76], adc_values[77], adc_values[78], adc_values[79], adc_values[80], 
+                   adc_values[82], adc_values[83], adc_values[84]);
+
+    pos += snprintf(adc_display + pos, sizeof(adc_display) - pos,
+                   "Scan rate: %lu Hz\n\n", (unsigned long)mux_scan_rate());
+    
+    // Send entire buffer at once via UART debug (bypasses HID console line buffering)
+    uart_debug_print(adc_display);
 }
 
 // Initialize ESP_RESET_PIN early to prevent bootloader trigger
@@ -114,116 +1694,428 @@ void matrix_init_custom(void) {
     writePinHigh(MUX_CS3);
 #endif
 
+#if MUX_SCAN_PARALLEL
+    // Parallel scan drives the ADC directly (round-robin over inputs 0..2)
+    adc_init();
+    adc_gpio_init(MUX1_ADC_PIN);
+    adc_gpio_init(MUX2_ADC_PIN);
+    adc_gpio_init(MUX3_ADC_PIN);
+#endif
+#if MUX_SCAN_PARALLEL
+    init_scan_order();
+#endif
+#if MUX_SCAN_PRIORITY
+    static const uint8_t hot_keys[] = {SCAN_HOT_KEYS};
+    for (uint8_t i = 0; i < sizeof(hot_keys); i++) {
+        key_priority[hot_keys[i] - 1] = 1;
+    }
+    scan_schedule_dirty = true;
+#endif
+
+#if MUX_SCAN_PIO
+    // Hand A0-A4/WR to the PIO engine; it scans continuously from here on
+    pio_scan = mux_pio_init();
+    if (!pio_scan) {
+        uart_send_string("[init] PIO scan unavailable, using the CPU scan\n");
+    }
+#endif
+
     // Initialize key state arrays
     for (uint8_t i = 0; i < MAX_KEYS; i++) {
         key_pressed[i] = false;
-        key_timer[i] = 0;
+        key_confirm[i] = 0;
+        key_rt[i] = (key_rt_t){
+            .press_delta   = travel_from_mm_x100(RAPID_TRIGGER_PRESS_MM_X100),
+            .release_delta = travel_from_mm_x100(RAPID_TRIGGER_RELEASE_MM_X100),
+            .mode          = RAPID_TRIGGER_DEFAULT_MODE,
+        };
+        travel_lut_linear(&key_lut[i]);
+        key_actuation_mm_x100[i] = KEY_ACTUATION_MM_X100;
+        key_reset_mm_x100[i] = KEY_RESET_MM_X100;
         key_baseline[i] = 0;
+        key_bottom_out[i] = ANALOG_BOTTOM_OUT_DEFAULT;
         key_threshold[i] = SENSOR_THRESHOLD; // Use default until calibration completes
+        update_key_band(i);
     }
 }
 
-// Auto-calibration: Scan all keys and establish baseline + dynamic thresholds
-// This should be called after matrix_init_custom, during keyboard_post_init_kb
-void calibrate_sensors(void) {
-    pin_t adc_pins[3] = {MUX1_ADC_PIN, MUX2_ADC_PIN, MUX3_ADC_PIN};
-    const mux32_ref_t* mux_tables[3] = {mux1_channels, mux2_channels, mux3_channels};
-    
-    // Perform multiple reads per key and average them for stability
-    const uint8_t CALIBRATION_SAMPLES = 5;
-    uint32_t sample_accumulator[MAX_KEYS] = {0};
-    uint8_t sample_count[MAX_KEYS] = {0};
-    
-    // Collect samples
-    for (uint8_t sample = 0; sample < CALIBRATION_SAMPLES; sample++) {
-        for (uint8_t mux_idx = 0; mux_idx < 3; mux_idx++) {
-            // Select appropriate CS
-#ifdef MUX_CS1
-            if (mux_idx == 0) { writePinLow(MUX_CS1); } else { writePinHigh(MUX_CS1); }
-#endif
-#ifdef MUX_CS2
-            if (mux_idx == 1) { writePinLow(MUX_CS2); } else { writePinHigh(MUX_CS2); }
-#endif
-#ifdef MUX_CS3
-            if (mux_idx == 2) { writePinLow(MUX_CS3); } else { writePinHigh(MUX_CS3); }
-#endif
-
-            for (uint8_t ch = 0; ch < 32; ch++) {
-                select_mux_channel(ch);
-                wait_us(100);
+// Legacy absolute fallback threshold (lower bound) for a resting value
+static uint16_t legacy_threshold(uint16_t baseline) {
+    uint16_t threshold = (baseline * CALIBRATION_THRESHOLD_PERCENT) / 100;
 
-                uint16_t adc_val = read_adc_pin(adc_pins[mux_idx]);
-                
-                // Filter out anomalous high values
-                const uint16_t ADC_MAX_VALID = 800;
-                if (adc_val > ADC_MAX_VALID) {
-                    adc_val = 4095;
-                }
+    // Safety clamps: ensure threshold is reasonable
+    if (threshold < 100) threshold = 100; // Minimum threshold
+    if (threshold > 700) threshold = 700; // Maximum threshold
+    return threshold;
+}
 
-                const mux32_ref_t* key_mapping = &mux_tables[mux_idx][ch + 1];
-                if (!key_mapping || key_mapping->sensor == 0) continue;
+// Integer square root (calibration only)
+static uint32_t isqrt32(uint32_t v) {
+    uint32_t root = 0;
+    for (uint32_t bit = 1u << 30; bit; bit >>= 2) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+    }
+    return root;
+}
 
-                uint16_t sensor = key_mapping->sensor;
-                uint8_t matrix_row = (sensor - 1) / MATRIX_COLS;
-                uint8_t matrix_col = (sensor - 1) % MATRIX_COLS;
+static void apply_calibration(void);
 
-                if (matrix_row >= MATRIX_ROWS || matrix_col >= MATRIX_COLS) continue;
+// Baseline measurement, one pass at a time (no keys pressed!): averages
+// CALIBRATION_SAMPLES passes taken CALIBRATION_SAMPLE_MS apart. At boot
+// measure_baselines takes them in a row; a host recalibration takes one
+// per matrix_scan_custom call, so key events keep flowing meanwhile.
+#define CALIBRATION_SAMPLE_MS 10
+static uint32_t sample_accumulator[MAX_KEYS];
+static uint32_t sample_squares[MAX_KEYS];
+static uint8_t sample_count[MAX_KEYS];
+static uint8_t samples_taken;
+static bool recalibration_running = false;
+static uint32_t recalibration_seq;      // core1: last snapshot sampled
+static uint32_t recalibration_time_ms;  // last sample taken
 
-                uint16_t key_idx = (matrix_row * MATRIX_COLS) + matrix_col;
-                if (key_idx >= MAX_KEYS) continue;
+static void baselines_begin(void) {
+    memset(sample_accumulator, 0, sizeof(sample_accumulator));
+    memset(sample_squares, 0, sizeof(sample_squares));
+    memset(sample_count, 0, sizeof(sample_count));
+    samples_taken = 0;
+#if MUX_SCAN_PRIORITY
+    // Statistics need a fresh sample of every key in every pass
+    scan_full_passes = true;
+#endif
+    // core1: the pass in progress may have started before the flag
+    recalibration_seq = (scan_snapshot.seq | 1) + 2;
+}
 
-                // Accumulate valid readings only (skip obvious disconnects)
-                if (adc_val < 4000) {
-                    sample_accumulator[key_idx] += adc_val;
-                    sample_count[key_idx]++;
-                }
-            }
+// Add one pass; true once CALIBRATION_SAMPLES are in
+static bool baselines_sample(const uint16_t frame[MAX_KEYS]) {
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        uint8_t key_idx = scan_plan[i].key_idx;
 
-            // Release CS
-#ifdef MUX_CS1
-            writePinHigh(MUX_CS1);
-#endif
-#ifdef MUX_CS2
-            writePinHigh(MUX_CS2);
-#endif
-#ifdef MUX_CS3
-            writePinHigh(MUX_CS3);
-#endif
+        // Accumulate valid readings only (skip obvious disconnects)
+        uint16_t adc_val = frame[key_idx];
+        if (adc_val < 4000) {
+            sample_accumulator[key_idx] += adc_val;
+            sample_squares[key_idx] += (uint32_t)adc_val * adc_val;
+            sample_count[key_idx]++;
         }
-        wait_ms(10); // Small delay between calibration samples
     }
-    
+    if (++samples_taken < CALIBRATION_SAMPLES) {
+        return false;
+    }
+#if MUX_SCAN_PRIORITY
+    scan_full_passes = false;
+#endif
+    return true;
+}
+
+// Make the measured baselines and noise live (apply_calibration). The
+// results go in with the scanner held, so drift tracking never steps a new
+// baseline against the old calibrated value or accumulator.
+static void baselines_finish(void) {
     // Calculate baseline and threshold for each key
+    scanner_hold();
     for (uint8_t key_idx = 0; key_idx < MAX_KEYS; key_idx++) {
         if (sample_count[key_idx] > 0) {
             // Calculate average baseline
-            key_baseline[key_idx] = sample_accumulator[key_idx] / sample_count[key_idx];
+            uint32_t n = sample_count[key_idx];
+            key_baseline[key_idx] = sample_accumulator[key_idx] / n;
+
+            // Noise: sigma^2 = (n*sum(x^2) - sum(x)^2) / n^2, kept x16 and
+            // floored at the ADC's quantization noise
+            uint64_t spread = (uint64_t)n * sample_squares[key_idx] - (uint64_t)sample_accumulator[key_idx] * sample_accumulator[key_idx];
+            uint16_t noise = (uint16_t)isqrt32((uint32_t)((spread * 256) / (n * n)));
+            key_noise_x16[key_idx] = (noise < KEY_NOISE_MIN_X16) ? KEY_NOISE_MIN_X16 : noise;
             
             // Initialize sensitivity percent to a default value (deviation percent)
             // e.g., default 4% -> trigger when value deviates +/-4% from baseline
             // Lower = more sensitive, Higher = less sensitive (requires harder press)
             // 4% is a good balance: responsive without noise/crosstalk false triggers
+            // A recalibration keeps sensitivities set from the host.
             const uint8_t DEFAULT_SENSITIVITY_PERCENT = 4;
-            key_sensitivity_percent[key_idx] = DEFAULT_SENSITIVITY_PERCENT;
+            if (!key_sensitivity_percent[key_idx]) {
+                key_sensitivity_percent[key_idx] = DEFAULT_SENSITIVITY_PERCENT;
+            }
 
             // Keep an absolute fallback threshold (lower bound) for compatibility
-            key_threshold[key_idx] = (key_baseline[key_idx] * CALIBRATION_THRESHOLD_PERCENT) / 100;
-            
-            // Safety clamps: ensure threshold is reasonable
-            if (key_threshold[key_idx] < 100) {
-                key_threshold[key_idx] = 100; // Minimum threshold
-            }
-            if (key_threshold[key_idx] > 700) {
-                key_threshold[key_idx] = 700; // Maximum threshold
-            }
+            key_threshold[key_idx] = legacy_threshold(key_baseline[key_idx]);
         } else {
             // No valid readings - use default
             key_baseline[key_idx] = 512;
             key_threshold[key_idx] = SENSOR_THRESHOLD;
         }
     }
-    
+
+#if TEMP_COMPENSATION
+    // Fresh baselines hold at the current temperature
+    temp_ref_x100 = temp_applied_x100 = temp_now_x100;
+    memset(key_temp_offset, 0, sizeof(key_temp_offset));
+#endif
+    apply_calibration();
+    scanner_release();
+}
+
+// Measure baselines now, blocking: boot, before core0 reports any keys
+static void measure_baselines(void) {
+    baselines_begin();
+    do {
+        if (core1_running()) {
+            // core1 owns the muxes; average its published passes instead
+            static matrix_row_t discard[MATRIX_ROWS];
+            uint32_t seq;
+            while ((int32_t)((seq = snapshot_read(discard, adc_frame)) - recalibration_seq) <= 0) {
+            }
+            recalibration_seq = seq;
+        } else {
+            scan_mux_frame(adc_frame);
+        }
+        wait_ms(CALIBRATION_SAMPLE_MS);
+    } while (!baselines_sample(adc_frame));
+    baselines_finish();
+}
+
+// Restore baselines and sensitivities from the stored record, if valid
+static bool restore_calibration(void) {
+    static calibration_data_t data;
+    if (!calibration_load(&data)) {
+        return false;
+    }
+
+    for (uint8_t key_idx = 0; key_idx < MAX_KEYS; key_idx++) {
+        key_baseline[key_idx] = data.baseline[key_idx];
+        key_sensitivity_percent[key_idx] = data.sensitivity_percent[key_idx];
+        key_bottom_out[key_idx] = data.bottom_out[key_idx] ? data.bottom_out[key_idx] : ANALOG_BOTTOM_OUT_DEFAULT;
+        key_actuation_mm_x100[key_idx] = data.actuation_mm_x100[key_idx];
+        key_reset_mm_x100[key_idx] = data.reset_mm_x100[key_idx];
+        key_polarity[key_idx] = data.polarity[key_idx];
+        key_noise_x16[key_idx] = data.noise_x16[key_idx];
+        key_sensitivity_sigma[key_idx] = data.sensitivity_sigma[key_idx];
+        key_threshold[key_idx] = legacy_threshold(key_baseline[key_idx]);
+#if CROSSTALK_COMPENSATION
+        for (uint8_t n = 0; n < CROSSTALK_NEIGHBORS; n++) {
+            bool valid = data.crosstalk_target[key_idx][n] < MAX_KEYS;
+            key_crosstalk_target[key_idx][n] = valid ? data.crosstalk_target[key_idx][n] : 0;
+            key_crosstalk_coef[key_idx][n] = valid ? data.crosstalk_coef[key_idx][n] : 0;
+        }
+#endif
+#if TEMP_COMPENSATION
+        key_temp_coef_q8[key_idx] = data.temp_coef_q8[key_idx];
+        key_temp_offset[key_idx] = 0;
+#endif
+    }
+#if TEMP_COMPENSATION
+    // Stored baselines belong to temp_ref_x100; the scanner moves them to
+    // the current temperature on its first sample
+    temp_ref_x100 = temp_applied_x100 = data.temp_ref_x100;
+#endif
+    return true;
+}
+
+// Store the live baselines and sensitivities. The copy is taken with the
+// scanner held (drift tracking moves the baselines); the flash write is not.
+static void store_calibration(void) {
+    static calibration_data_t data;
+    scanner_hold();
+    memcpy(data.baseline, key_baseline, sizeof(data.baseline));
+    memcpy(data.sensitivity_percent, key_sensitivity_percent, sizeof(data.sensitivity_percent));
+    memcpy(data.bottom_out, key_bottom_out, sizeof(data.bottom_out));
+    memcpy(data.actuation_mm_x100, key_actuation_mm_x100, sizeof(data.actuation_mm_x100));
+    memcpy(data.reset_mm_x100, key_reset_mm_x100, sizeof(data.reset_mm_x100));
+    memcpy(data.polarity, key_polarity, sizeof(data.polarity));
+    memcpy(data.noise_x16, key_noise_x16, sizeof(data.noise_x16));
+    memcpy(data.sensitivity_sigma, key_sensitivity_sigma, sizeof(data.sensitivity_sigma));
+#if CROSSTALK_COMPENSATION
+    memcpy(data.crosstalk_target, key_crosstalk_target, sizeof(data.crosstalk_target));
+    memcpy(data.crosstalk_coef, key_crosstalk_coef, sizeof(data.crosstalk_coef));
+#endif
+#if TEMP_COMPENSATION
+    // Baselines are stored as they are at the reference temperature
+    for (uint8_t key_idx = 0; key_idx < MAX_KEYS; key_idx++) {
+        data.baseline[key_idx] = (uint16_t)(data.baseline[key_idx] - key_temp_offset[key_idx]);
+    }
+    memcpy(data.temp_coef_q8, key_temp_coef_q8, sizeof(data.temp_coef_q8));
+    data.temp_ref_x100 = temp_ref_x100;
+#endif
+    scanner_release();
+    calibration_save(&data);
+    calibration_dirty = false;
+}
+
+// Make new baselines live: rebuild the travel curves and cached bands, and
+// restart drift tracking. Scanner held or not running yet.
+static void apply_calibration(void) {
     calibration_complete = true;
+    for (uint8_t key_idx = 0; key_idx < MAX_KEYS; key_idx++) {
+        travel_lut_build(&key_lut[key_idx], key_baseline[key_idx], key_bottom_out[key_idx], key_polarity[key_idx]);
+        update_key_band(key_idx);
+#if BASELINE_DRIFT_TRACKING
+        key_baseline_cal[key_idx] = key_baseline[key_idx];
+        key_baseline_acc[key_idx] = (uint32_t)key_baseline[key_idx] << BASELINE_DRIFT_SHIFT;
+#endif
+    }
+}
+
+// Boot-time calibration: load the stored record, or measure (and store) a
+// new one if it is missing or stale. Called after matrix_init_custom,
+// during keyboard_post_init_user.
+void calibrate_sensors(void) {
+#if TEMP_COMPENSATION
+    // First reading before anything depends on it (core1 is not running yet)
+    adc_set_temp_sensor_enabled(true);
+    temp_now_x100 = temp_applied_x100 = read_temperature_x100();
+    temp_last_us = time_us_32();
+#endif
+#if MUX_SCAN_ORDER_OPTIMIZE
+    // Order first: settle times depend on which address comes before
+    optimize_scan_order();
+#endif
+#if MUX_SETTLE_ADAPTIVE
+    // Settling is a property of the board and this boot's levels; always measure
+    measure_settle_times();
+#endif
+
+    if (restore_calibration()) {
+        uart_send_string("[calib] Loaded stored calibration\n");
+        apply_calibration();
+    } else {
+        uart_send_string("[calib] No valid stored calibration, measuring\n");
+        measure_baselines();
+        store_calibration();
+    }
+
+#if MUX_SCAN_CORE1
+    // Hand scanning to core1 once baselines exist; from here on
+    // matrix_scan_custom only copies the published snapshot.
+    core1_launch(scan_core1_main);
+#endif
+}
+
+// Host recalibration, from matrix_scan_custom: sample the pass just scanned
+// or copied (`seq` = its snapshot, core1) once the interval is up; `fresh`
+// says this call has one
+static void recalibration_tick(uint32_t seq, bool fresh) {
+    if (!recalibration_running || !fresh || timer_elapsed32(recalibration_time_ms) < CALIBRATION_SAMPLE_MS) {
+        return;
+    }
+    if (core1_running()) {
+        if ((int32_t)(seq - recalibration_seq) <= 0) {
+            return;  // not a pass newer than the last one sampled
+        }
+        recalibration_seq = seq;
+    }
+    recalibration_time_ms = timer_read32();
+    if (baselines_sample(adc_frame)) {
+        recalibration_running = false;
+        baselines_finish();
+        store_calibration();
+    }
+}
+
+// Explicit recalibration (host request): start measuring again; the
+// samples are taken and the result stored by matrix_scan_custom. Keys must
+// stay released until mux_recalibrating() goes false.
+void recalibrate_sensors(void) {
+    baselines_begin();
+    recalibration_time_ms = timer_read32();
+    recalibration_running = true;
+}
+
+bool mux_recalibrating(void) {
+    return recalibration_running;
+}
+
+// Bottom-out capture: start, have the user press every key fully, then stop.
+// Keys whose deepest travel reached ANALOG_BOTTOM_OUT_MIN take the captured
+// value and the polarity it was reached in; the result is stored with the
+// calibration.
+void capture_bottom_out(bool start) {
+    if (start) {
+        scanner_hold();
+        memset(key_capture_min, 0xFF, sizeof(key_capture_min));
+        memset(key_capture_max, 0, sizeof(key_capture_max));
+        bottom_out_capture = true;
+        scanner_release();
+        return;
+    }
+    if (!bottom_out_capture) return;
+
+    scanner_hold();
+    bottom_out_capture = false;
+    for (uint8_t key_idx = 0; key_idx < MAX_KEYS; key_idx++) {
+        uint16_t base = key_baseline[key_idx];
+        uint16_t up = (key_capture_max[key_idx] > base) ? key_capture_max[key_idx] - base : 0;
+        uint16_t down = (key_capture_min[key_idx] < base) ? base - key_capture_min[key_idx] : 0;
+        uint16_t depth = (up > down) ? up : down;
+
+        if (depth >= ANALOG_BOTTOM_OUT_MIN) {
+            key_bottom_out[key_idx] = depth;
+            key_polarity[key_idx] = (up > down) ? 1 : -1;
+            travel_lut_build(&key_lut[key_idx], key_baseline[key_idx], key_bottom_out[key_idx], key_polarity[key_idx]);
+            update_key_band(key_idx);
+        }
+    }
+    scanner_release();
+    store_calibration();
+}
+
+void capture_crosstalk(bool start) {
+#if CROSSTALK_COMPENSATION
+    if (start) {
+#if MUX_SCAN_PRIORITY
+        scan_full_passes = true;  // every pass must see every key
+#endif
+        crosstalk_capture = true;
+        return;
+    }
+    if (!crosstalk_capture) return;
+    crosstalk_capture = false;
+#if MUX_SCAN_PRIORITY
+    scan_full_passes = false;
+#endif
+
+    // The scanner finishes the last held key on its next pass; the delayed
+    // save runs well after that
+    calibration_dirty = true;
+    calibration_dirty_time = timer_read32();
+#endif
+}
+
+// The warm-up sums and the slopes are the scanner's between passes
+// (temperature_tick), so both ends of a warm-up hold it
+void learn_temperature(bool start) {
+#if TEMP_COMPENSATION
+    scanner_hold();
+    if (start) {
+        temp_fit.n = 0;
+        temp_fit.sum_t = temp_fit.sum_tt = 0;
+        memset(temp_fit_sum_x, 0, sizeof(temp_fit_sum_x));
+        memset(temp_fit_sum_tx, 0, sizeof(temp_fit_sum_tx));
+        temp_learning = true;
+    } else if (temp_learning) {
+        temp_learning = false;
+        temp_learn_finish();
+        calibration_dirty = true;
+        calibration_dirty_time = timer_read32();
+    }
+    scanner_release();
+#endif
+}
+
+void mux_temperature(mux_temperature_t *temp) {
+    memset(temp, 0, sizeof(*temp));
+#if TEMP_COMPENSATION
+    scanner_hold();
+    temp->now_x100 = temp_now_x100;
+    temp->ref_x100 = temp_ref_x100;
+    temp->learning = temp_learning;
+    temp->learn_samples = temp_fit.n;
+    temp->learn_span_x100 = temp_fit.n ? (uint16_t)(temp_fit.t_max - temp_fit.t_min) : 0;
+    scanner_release();
+#endif
 }
 
 // Allow external modules to set a per-key sensitivity percent (deviation percent)
@@ -235,6 +2127,7 @@ void set_key_threshold(uint16_t key_idx, uint8_t percent) {
     if (percent < 1) percent = 1;
     if (percent > 90) percent = 90;
 
+    scanner_hold();
     key_sensitivity_percent[key_idx] = percent;
 
     // Also update legacy absolute threshold for compatibility (lower bound only)
@@ -243,182 +2136,227 @@ void set_key_threshold(uint16_t key_idx, uint8_t percent) {
     if (abs_t < 100) abs_t = 100;
     if (abs_t > 700) abs_t = 700;
     key_threshold[key_idx] = (uint16_t)abs_t;
-}
 
-bool matrix_scan_custom(matrix_row_t current_matrix[]) {
-    bool changed = false;
-    uint32_t now = timer_read32();
+    update_key_band(key_idx);
+    scanner_release();
 
-    // Throttle matrix scan to ~667Hz (1.5ms between scans) - faster for better response
-    static uint32_t last_scan = 0;
-    if (timer_elapsed32(last_scan) < 2) {  // QMK timer is 1ms resolution, so use 2ms
-        return false;
-    }
-    last_scan = now;
+    // Persist once the host stops sending changes
+    calibration_dirty = true;
+    calibration_dirty_time = timer_read32();
+}
 
-    // Clear matrix output
-    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
-        current_matrix[row] = 0;
-    }
-    
-    // Clear ADC values array
-    for (uint8_t i = 0; i < 90; i++) {
-        adc_values[i] = 0;
-    }
+// Set a key's sensitivity in multiples of its measured noise (0 returns it to
+// the sensitivity percent). Millimetre actuation points still take priority.
+void set_key_sensitivity_sigma(uint16_t key_idx, uint8_t multiple) {
+    if (key_idx >= MAX_KEYS) return;
 
-    // ADC pins and mapping tables
-    pin_t adc_pins[3] = {MUX1_ADC_PIN, MUX2_ADC_PIN, MUX3_ADC_PIN};
-    const mux32_ref_t* mux_tables[3] = {mux1_channels, mux2_channels, mux3_channels};
+    scanner_hold();
+    key_sensitivity_sigma[key_idx] = multiple;
+    update_key_band(key_idx);
+    scanner_release();
 
-    const uint16_t ADC_GND_THRESHOLD = 100; // skip obviously unconnected channels
+    calibration_dirty = true;
+    calibration_dirty_time = timer_read32();
+}
 
-    // Scan each mux and channel
-    for (uint8_t mux_idx = 0; mux_idx < 3; mux_idx++) {
-        // Select appropriate CS
-#ifdef MUX_CS1
-        if (mux_idx == 0) { writePinLow(MUX_CS1); } else { writePinHigh(MUX_CS1); }
-#endif
-#ifdef MUX_CS2
-        if (mux_idx == 1) { writePinLow(MUX_CS2); } else { writePinHigh(MUX_CS2); }
-#endif
-#ifdef MUX_CS3
-        if (mux_idx == 2) { writePinLow(MUX_CS3); } else { writePinHigh(MUX_CS3); }
+// Measured resting noise of a key (standard deviation, ADC counts x16)
+uint16_t get_key_noise_x16(uint16_t key_idx) {
+    return (key_idx < MAX_KEYS) ? key_noise_x16[key_idx] : 0;
+}
+
+uint16_t get_key_oversamples(uint16_t key_idx) {
+#if MUX_SCAN_OVERSAMPLE
+    return (key_idx < MAX_KEYS) ? key_oversample_rate[key_idx] : 0;
+#else
+    return 0;
 #endif
+}
 
-        for (uint8_t ch = 0; ch < 32; ch++) {
-            select_mux_channel(ch);
-            wait_us(100);  // Increased delay without filter caps to allow signal settling
+// Set a key's actuation and reset points in 0.01 mm of travel. actuation 0
+// returns the key to its sensitivity percent; reset 0 uses
+// KEY_RELEASE_PERCENT of the actuation point.
+void set_key_actuation(uint16_t key_idx, uint16_t actuation_mm_x100, uint16_t reset_mm_x100) {
+    if (key_idx >= MAX_KEYS) return;
+    if (actuation_mm_x100 > KEY_TRAVEL_MM_X100) actuation_mm_x100 = KEY_TRAVEL_MM_X100;
 
-            uint16_t adc_val = read_adc_pin(adc_pins[mux_idx]);
-            
-            // Filter out anomalous high values (crosstalk without filter caps)
-            // Valid Hall sensor range: 0 (pressed) to ~512 (released)
-            // Values above 800 are likely crosstalk
-            const uint16_t ADC_MAX_VALID = 800;
-            if (adc_val > ADC_MAX_VALID) {
-                adc_val = 4095;  // Treat as invalid/unpressed
-            }
+    scanner_hold();
+    key_actuation_mm_x100[key_idx] = actuation_mm_x100;
+    key_reset_mm_x100[key_idx] = reset_mm_x100;
+    update_key_band(key_idx);
+    scanner_release();
 
-            const mux32_ref_t* key_mapping = &mux_tables[mux_idx][ch + 1];
-            if (!key_mapping) continue;
+    calibration_dirty = true;
+    calibration_dirty_time = timer_read32();
+}
 
-            // If channel is unmapped and reads near GND, skip
-            if (key_mapping->sensor == 0) {
-                if (adc_val <= ADC_GND_THRESHOLD) continue;
-                else continue;
-            }
+// Configure rapid trigger for one key. Deltas are in 0.01 mm of travel;
+// 0 keeps the current value.
+void set_key_rapid_trigger(uint16_t key_idx, uint8_t mode, uint8_t press_mm_x100, uint8_t release_mm_x100) {
+    if (key_idx >= MAX_KEYS) return;
+    if (mode > RAPID_TRIGGER_CONTINUOUS) mode = RAPID_TRIGGER_OFF;
 
-            uint16_t sensor = key_mapping->sensor;
-            if (sensor == 0) continue;
+    key_rt_t *rt = &key_rt[key_idx];
+    scanner_hold();
+    if (press_mm_x100) rt->press_delta = travel_from_mm_x100(press_mm_x100);
+    if (release_mm_x100) rt->release_delta = travel_from_mm_x100(release_mm_x100);
+    rt->armed = false;
+    rt->mode = mode;
+    scanner_release();
+}
 
-            // Map sensor to matrix position
-            uint8_t matrix_row = (sensor - 1) / MATRIX_COLS;
-            uint8_t matrix_col = (sensor - 1) % MATRIX_COLS;
+#if MUX_SCAN_PRIORITY
+// Make a key hot (sampled every pass) or cold (sampled in rotation). The
+// scanner picks the change up at the start of its next pass.
+void set_key_priority(uint16_t key_idx, bool hot) {
+    if (key_idx >= MAX_KEYS) return;
 
-            if (matrix_row >= MATRIX_ROWS || matrix_col >= MATRIX_COLS) continue;
+    key_priority[key_idx] = hot;
+    scan_schedule_dirty = true;
+}
 
-            uint16_t key_idx = (matrix_row * MATRIX_COLS) + matrix_col;
-            if (key_idx >= MAX_KEYS) continue;
-            
-            // Store ADC value for debug display (show filtered value)
-            if (key_idx < 90) {
-                adc_values[key_idx] = adc_val;
-            }
+// Worst-case staleness of a cold key, in passes: every cold address is
+// sampled once per ceil(cold addresses / SCAN_COLD_SLICE) passes, hot
+// addresses every pass. Counted from key_priority so it already reflects a
+// change the scanner has not picked up yet.
+uint8_t mux_scan_cold_interval(void) {
+    uint8_t cold = 0;
+    for (uint8_t o = 0; o < scan_order_len; o++) {
+        bool hot = false;
+        uint8_t ch = scan_plan[scan_order[o]].channel;
+        for (uint8_t i = scan_order[o]; i < SCAN_PLAN_LEN && scan_plan[i].channel == ch; i++) {
+            hot |= key_priority[scan_plan[i].key_idx] != 0;
+        }
+        cold += !hot;
+    }
+    return (cold <= SCAN_COLD_SLICE) ? 1 : (uint8_t)((cold + SCAN_COLD_SLICE - 1) / SCAN_COLD_SLICE);
+}
+#endif
 
-            // Use dynamic per-key sensitivity if calibration is complete
-            bool should_press = false;
-            if (calibration_complete) {
-                uint16_t base = key_baseline[key_idx] ? key_baseline[key_idx] : 512;
-                uint8_t sens = key_sensitivity_percent[key_idx] ? key_sensitivity_percent[key_idx] : 10; // percent
-
-                // Compute lower and upper bounds based on percent deviation
-                uint32_t lower = ((uint32_t)base * (100 - sens)) / 100;
-                uint32_t upper = ((uint32_t)base * (100 + sens)) / 100;
-
-                // Safety clamps
-                if (lower < 1) lower = 1;
-                if (upper > 4095) upper = 4095;
-
-                // Press if value deviates below lower OR above upper
-                should_press = (adc_val < lower) || (adc_val > upper);
-            } else {
-                // Fallback to legacy absolute threshold
-                uint16_t threshold = key_threshold[key_idx] ? key_threshold[key_idx] : SENSOR_THRESHOLD;
-                should_press = (adc_val < threshold);
-            }
+// time_us_64() of the sample behind the key's latest change in the matrix
+// QMK sees (0 before its first change). Valid while QMK processes that change.
+uint64_t mux_key_change_us(uint8_t row, uint8_t col) {
+    if (row >= MATRIX_ROWS || col >= MATRIX_COLS) return 0;
+    return key_change_us[row * MATRIX_COLS + col];
+}
+
+#if KEY_PREDICTIVE_ACTUATION
+// Set how far ahead predictive actuation looks, in percent of a key's sample
+// interval (0 turns it off)
+void set_predictive_lead(uint8_t percent) {
+    predict_lead_percent = percent;
+}
+#endif
+
+// Achieved full-board scan rate (passes per second, updated once a second)
+uint32_t mux_scan_rate(void) {
+    mux_scan_stats_t stats;
+    mux_scan_stats(&stats);
+    return stats.passes_per_s;
+}
+
+// Copy the latest one-second pipeline counters (retried if the scanner
+// publishes meanwhile)
+void mux_scan_stats(mux_scan_stats_t *stats) {
+    uint32_t seq;
+    do {
+        seq = scan_stats_seq;
+        __dmb();
+        *stats = scan_stats;
+        __dmb();
+    } while ((seq & 1) || seq != scan_stats_seq);
+}
+
+bool matrix_scan_custom(matrix_row_t current_matrix[]) {
+    bool changed = false;
+    uint32_t now = timer_read32();
+    bool fresh = false;  // adc_frame holds a pass from this call
+    uint32_t frame_seq = 0;
+
+#if MUX_SCAN_CORE1
+    if (core1_running()) {
+        // core1 owns the muxes; replay its key transitions in order. Each
+        // key changes at most once per call, so a tap shorter than a main
+        // loop iteration still reaches QMK as a press and then a release.
+        static matrix_row_t snapshot_matrix[MATRIX_ROWS];
+        static bool resync = false;
+        static uint32_t resync_seq;
 
-            // Debounce: only change state if debounce time elapsed
-            if (timer_elapsed32(key_timer[key_idx]) > DEBOUNCE_MS) {
-                if (should_press != key_pressed[key_idx]) {
-                    key_pressed[key_idx] = should_press;
-                    key_timer[key_idx] = now;
-                    changed = true;
+        if (key_events_overflowed()) {
+            // Events were lost: drop the rest and take the matrix from the
+            // first snapshot published after the pass now in progress
+            key_events_flush();
+            resync = true;
+            resync_seq = snapshot_read(snapshot_matrix, adc_frame) + 2;
+        }
+
+        uint32_t seq = snapshot_read(snapshot_matrix, adc_frame);
+        fresh = true;
+        frame_seq = seq;
+        if (resync) {
+            if ((int32_t)(seq - resync_seq) >= 0) {
+                changed = memcmp(current_matrix, snapshot_matrix, sizeof(snapshot_matrix)) != 0;
+                memcpy(current_matrix, snapshot_matrix, sizeof(snapshot_matrix));
+                resync = false;
+                // Changes queued since the flush by passes up to this
+                // snapshot are in it already; replaying them would tap
+                const key_event_t *ev;
+                while ((ev = key_events_peek()) != NULL && (int32_t)(ev->seq - seq) <= 0) {
+                    key_events_drop();
                 }
             }
+        } else {
+            matrix_row_t touched[MATRIX_ROWS] = {0};
+            const key_event_t *ev;
+
+            while ((ev = key_events_peek()) != NULL) {
+                uint8_t row = ev->key_idx / MATRIX_COLS;
+                matrix_row_t bit = (matrix_row_t)1 << (ev->key_idx % MATRIX_COLS);
+                if (touched[row] & bit) {
+                    break;  // its next change goes in the next call
+                }
+                touched[row] |= bit;
 
-            if (key_pressed[key_idx]) {
-                current_matrix[matrix_row] |= (1 << matrix_col);
+                matrix_row_t old = current_matrix[row];
+                current_matrix[row] = ev->pressed ? (old | bit) : (old & ~bit);
+                changed |= current_matrix[row] != old;
+                key_change_us[ev->key_idx] = ev->time_us;
+                key_events_drop();
             }
         }
-
-        // Release CS for this MUX (keep others disabled)
-#ifdef MUX_CS1
-        writePinHigh(MUX_CS1);
-#endif
-#ifdef MUX_CS2
-        writePinHigh(MUX_CS2);
+    } else
 #endif
-#ifdef MUX_CS3
-        writePinHigh(MUX_CS3);
+    {
+        // Time the pass against USB start-of-frame; when it is not due, skip
+        // only the scan so the housekeeping below still runs
+        uint32_t start_us = time_us_32();
+        if (scan_governor_due(start_us)) {
+            scanned_frame = sof_frame;
+
+            // Sample every wired input, then evaluate each key
+            scan_mux_frame(adc_frame);
+            changed = evaluate_frame(current_matrix, adc_frame);
+            fresh = true;
+
+            uint32_t pass_us = time_us_32() - start_us;
+            scan_pass_us = scan_pass_us ? (scan_pass_us * 7 + pass_us) / 8 : pass_us;
+            scan_stats_tick(pass_us);
+#if TEMP_COMPENSATION
+            temperature_tick(adc_frame);
 #endif
+        }
+    }
+
+    recalibration_tick(frame_seq, fresh);
+
+    // Save host-set sensitivities after a quiet period (one flash write per batch)
+    if (calibration_dirty && calibration_complete && timer_elapsed32(calibration_dirty_time) > CALIBRATION_SAVE_DELAY_MS) {
+        store_calibration();
     }
 
     // Print ADC values if debug enabled (every 1000ms = 1 second)
     if (get_adc_debug_enabled() && timer_elapsed32(last_adc_print_time) > ADC_PRINT_INTERVAL_MS) {
         last_adc_print_time = now;
-        
-        // Build entire display in one giant buffer matching zuart.txt format exactly
-        static char adc_display[1200];
-        int pos = 0;
-        
-        // Row 0: F-keys (14 positions, using indices 0-11,12,13 skipping 11 for F11)
-        pos += snprintf(adc_display + pos, sizeof(adc_display) - pos, 
-                       "|Esc:   %04d |F1:  %04d |F2    %04d |F3:  %04d |F4:   %04d |F5: %04d |F6: %04d |F7: %04d |F8: %04d |F9: %04d |F10: %04d |F12:   %04d |Del: %04d |\n",
-                       adc_values[0], adc_values[1], adc_values[2], adc_values[3], adc_values[4], adc_values[5], 
-                       adc_values[6], adc_values[7], adc_values[8], adc_values[9], adc_values[10], adc_values[12], adc_values[13]);
-        
-        // Row 1: Number row (15 positions, indices 15-29)
-        pos += snprintf(adc_display + pos, sizeof(adc_display) - pos,
-                       "|`:     %04d |1:   %04d |2:    %04d |3:   %04d |4:    %04d |5:  %04d |6:  %04d |7:  %04d |8:  %04d |9:  %04d |0:   %04d |-:     %04d |=:   %04d |Back: %04d |\n",
-                       adc_values[15], adc_values[16], adc_values[17], adc_values[18], adc_values[19], adc_values[20], 
-                       adc_values[21], adc_values[22], adc_values[23], adc_values[24], adc_values[25], adc_values[26], adc_values[27], adc_values[28]);
-        
-        // Row 2: QWERTY row (15 positions, indices 30-44)
-        pos += snprintf(adc_display + pos, sizeof(adc_display) - pos,
-                       "|Tab:   %04d |Q:   %04d |W:    %04d |E:   %04d |R:    %04d |T:  %04d |Y:  %04d |U:  %04d |I:  %04d |O:  %04d |P:   %04d |[:     %04d |]:   %04d |Home: %04d |\n",
-                       adc_values[30], adc_values[31], adc_values[32], adc_values[33], adc_values[34], adc_values[35], 
-                       adc_values[36], adc_values[37], adc_values[38], adc_values[39], adc_values[40], adc_values[41], adc_values[42], adc_values[44]);
-        
-        // Row 3: ASDF row (14 positions, indices 45-58)
-        pos += snprintf(adc_display + pos, sizeof(adc_display) - pos,
-                       "|Caps:  %04d |A:   %04d |S:    %04d |D:   %04d |F:    %04d |G:  %04d |H:  %04d |J:  %04d |K:  %04d |L:  %04d |;:   %04d |':     %04d |Ent: %04d |PgUp: %04d |\n",
-                       adc_values[45], adc_values[46], adc_values[47], adc_values[48], adc_values[49], adc_values[50], 
-                       adc_values[51], adc_values[52], adc_values[53], adc_values[54], adc_values[55], adc_values[56], adc_values[57], adc_values[58]);
-        
-        // Row 4: ZXCV row (13 positions, indices 60-72 with padding)
-        pos += snprintf(adc_display + pos, sizeof(adc_display) - pos,
-                       "|LShft: %04d |Z:   %04d |X:    %04d |C:   %04d |V:    %04d |B:  %04d |N:  %04d |M:  %04d |,:  %04d |.:  %04d |/:   %04d |RShft: %04d |↑:   %04d |\n",
-                       adc_values[60], adc_values[61], adc_values[62], adc_values[63], adc_values[64], adc_values[65], 
-                       adc_values[66], adc_values[67], adc_values[68], adc_values[69], adc_values[70], adc_values[71], adc_values[72]);
-        
-        // Row 5: Bottom row (10 positions, indices 75-84 with padding)
-        pos += snprintf(adc_display + pos, sizeof(adc_display) - pos,
-                       "|Ctrl:  %04d |Win: %04d |RAlt: %04d |                      Spc: %04d                     |Alt:%04d |Fn: %04d |          |←:     %04d |↓:   %04d |→:    %04d |\n\n",
-                       adc_values[75], adc_values[76], adc_values[77], adc_values[78], adc_values[79], adc_values[80], 
-                       adc_values[82], adc_values[83], adc_values[84]);
-        
-        // Send entire buffer at once via UART debug (bypasses HID console line buffering)
-        uart_debug_print(adc_display);
+        print_adc_table();
     }
 
     (void)debug_counter; (void)last_debug_time;
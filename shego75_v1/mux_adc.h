@@ -34,16 +34,410 @@
 #define CALIBRATION_THRESHOLD_PERCENT 85
 #endif
 
+// Analog travel normalization (analog_matrix.h): travel in ADC counts that
+// counts as bottomed out before a capture, and the smallest captured travel
+// accepted as a real bottom-out
+#ifndef ANALOG_BOTTOM_OUT_DEFAULT
+#define ANALOG_BOTTOM_OUT_DEFAULT 200
+#endif
+#ifndef ANALOG_BOTTOM_OUT_MIN
+#define ANALOG_BOTTOM_OUT_MIN 40
+#endif
+
+// Median-of-3 over each key's last three passes, so a single-pass spike
+// cannot register a keystroke. Off by default: it delays every real step by
+// a pass, and invalid samples already keep a key's state.
+#ifndef SPIKE_FILTER
+#define SPIKE_FILTER 0
+#endif
+
+// Passes averaged per calibration; also the sample size for each key's
+// noise estimate
+#ifndef CALIBRATION_SAMPLES
+#define CALIBRATION_SAMPLES 16
+#endif
+
+// Noise floor (ADC counts x16): quantization alone gives ~0.29 counts
+#ifndef KEY_NOISE_MIN_X16
+#define KEY_NOISE_MIN_X16 5
+#endif
+
+// Delay after the last set_key_threshold() before the calibration record is
+// rewritten, so a host updating many keys causes a single flash write
+#ifndef CALIBRATION_SAVE_DELAY_MS
+#define CALIBRATION_SAVE_DELAY_MS 2000
+#endif
+
+
+// Scan mode: 1 = latch one address into all three ADG732s and sample
+// GP26/GP27/GP28 back to back via the ADC round-robin (one settle wait per
+// address); 0 = legacy serial scan, one mux at a time via analogReadPin.
+#ifndef MUX_SCAN_PARALLEL
+#define MUX_SCAN_PARALLEL 1
+#endif
+
+// Let a PIO state machine sequence A0-A4/WR and pace the ADC while DMA
+// collects samples (see mux_pio.h); the CPU only copies finished passes.
+// Settle time is then MUX_PIO_SETTLE_US; its default of 10 scans at about
+// 1.8 kHz, and 4 kHz or more needs MUX_PIO_SETTLE_US 0. Needs
+// MUX_SCAN_PARALLEL.
+#ifndef MUX_SCAN_PIO
+#define MUX_SCAN_PIO 0
+#endif
+#if MUX_SCAN_PIO && !MUX_SCAN_PARALLEL
+#error "MUX_SCAN_PIO requires MUX_SCAN_PARALLEL"
+#endif
+
+// Run the scan continuously on core1 (after calibration) and publish each
+// pass through a seqlock; matrix_scan_custom then only copies the snapshot.
+// Needs MUX_SCAN_PARALLEL since analogReadPin is not safe off core0.
+#ifndef MUX_SCAN_CORE1
+#define MUX_SCAN_CORE1 1
+#endif
+#if MUX_SCAN_CORE1 && !MUX_SCAN_PARALLEL
+#error "MUX_SCAN_CORE1 requires MUX_SCAN_PARALLEL"
+#endif
+
+// With core1 scanning, start each pass on RP2040 hardware alarm
+// SCAN_ALARM_NUM every MUX_SCAN_PERIOD_US instead of back to back
+// (0 = back to back). ChibiOS's system timer uses the low alarms.
+#ifndef MUX_SCAN_PERIOD_US
+#define MUX_SCAN_PERIOD_US 0
+#endif
+#ifndef SCAN_ALARM_NUM
+#define SCAN_ALARM_NUM 3
+#endif
+#if MUX_SCAN_PERIOD_US && !MUX_SCAN_CORE1
+#error "MUX_SCAN_PERIOD_US requires MUX_SCAN_CORE1"
+#endif
+
+// Settle time after latching a new mux address (no filter caps on the board)
+#ifndef MUX_SETTLE_US
+#define MUX_SETTLE_US 100
+#endif
+
+// Release hysteresis: a pressed key releases once its deviation from the
+// baseline falls back under this percent of the press deviation (100 = no
+// hysteresis).
+#ifndef KEY_RELEASE_PERCENT
+#define KEY_RELEASE_PERCENT 50
+#endif
+
+// Consecutive samples that must agree before a key changes state. 1 acts on
+// the first sample past the band; raise it for noisy sensors.
+#ifndef KEY_CONFIRM_SAMPLES
+#define KEY_CONFIRM_SAMPLES 1
+#endif
+
+// Rapid trigger modes (per key, see set_key_rapid_trigger)
+#define RAPID_TRIGGER_OFF        0  // fixed bands only
+#define RAPID_TRIGGER_ON         1  // active past the actuation point
+#define RAPID_TRIGGER_CONTINUOUS 2  // stays armed until the key fully returns
+
+#ifndef RAPID_TRIGGER_DEFAULT_MODE
+#define RAPID_TRIGGER_DEFAULT_MODE RAPID_TRIGGER_OFF
+#endif
+
+// Default travel, in 0.01 mm, a pressed key must rise to release and a
+// released key must sink to re-actuate while rapid trigger is armed.
+#ifndef RAPID_TRIGGER_PRESS_MM_X100
+#define RAPID_TRIGGER_PRESS_MM_X100 15
+#endif
+#ifndef RAPID_TRIGGER_RELEASE_MM_X100
+#define RAPID_TRIGGER_RELEASE_MM_X100 15
+#endif
+
+// Default actuation/reset points in 0.01 mm of linearized travel (see
+// travel_lut.h for KEY_TRAVEL_MM_X100). 0 = use the sensitivity percent.
+#ifndef KEY_ACTUATION_MM_X100
+#define KEY_ACTUATION_MM_X100 0
+#endif
+#ifndef KEY_RESET_MM_X100
+#define KEY_RESET_MM_X100 0
+#endif
+
+// Predictive actuation (static actuation only, not rapid trigger): track
+// each key's travel velocity and press as soon as the travel extrapolated
+// PREDICT_LEAD_PERCENT of a sample interval ahead reaches the actuation
+// point. Only past the release point and above PREDICT_MIN_SPEED (travel
+// units per sample); larger leads trade false actuations for latency.
+#ifndef KEY_PREDICTIVE_ACTUATION
+#define KEY_PREDICTIVE_ACTUATION 0
+#endif
+#ifndef PREDICT_LEAD_PERCENT
+#define PREDICT_LEAD_PERCENT 100
+#endif
+#ifndef PREDICT_MIN_SPEED
+#define PREDICT_MIN_SPEED 8
+#endif
+
+// Magnetic crosstalk compensation: a key's offset from rest leaks into up to
+// CROSSTALK_NEIGHBORS other keys by measured coefficients (capture_crosstalk),
+// which are subtracted from their samples every pass. Costs at most
+// SCAN_PLAN_LEN x CROSSTALK_NEIGHBORS multiply-adds per pass; no-op until a
+// capture has been stored. A key needs CROSSTALK_MIN_PASSES passes held
+// alone during the capture for its coefficients to be taken.
+#ifndef CROSSTALK_COMPENSATION
+#define CROSSTALK_COMPENSATION 1
+#endif
+#ifndef CROSSTALK_NEIGHBORS
+#define CROSSTALK_NEIGHBORS 3
+#endif
+#ifndef CROSSTALK_MIN_PASSES
+#define CROSSTALK_MIN_PASSES 32
+#endif
+
+// Track slow baseline drift on released keys (see track_baseline_drift).
+// Every BASELINE_DRIFT_PASSES passes the resting sample feeds an IIR of
+// 2^BASELINE_DRIFT_SHIFT updates; the baseline moves one count at a time
+// and stays within BASELINE_DRIFT_MAX counts of its calibrated value.
+#ifndef BASELINE_DRIFT_TRACKING
+#define BASELINE_DRIFT_TRACKING 1
+#endif
+#ifndef BASELINE_DRIFT_PASSES
+#define BASELINE_DRIFT_PASSES 64
+#endif
+#ifndef BASELINE_DRIFT_SHIFT
+#define BASELINE_DRIFT_SHIFT 4
+#endif
+#ifndef BASELINE_DRIFT_MAX
+#define BASELINE_DRIFT_MAX 40
+#endif
+
+// Temperature compensation (parallel CPU scan, which owns the ADC and reads
+// the sensor on input 4 directly): every TEMP_SAMPLE_MS the scanner
+// reads the RP2040's internal sensor between passes and, once the smoothed
+// temperature has moved TEMP_STEP_X100 (0.01 degC), shifts each key's
+// baseline by its learned slope (learn_temperature) times the distance from
+// the temperature the baselines were measured at. TEMP_SENSITIVITY_PPM_PER_C
+// also scales every key's full-travel span (0 = offsets only). A warm-up
+// fit needs TEMP_LEARN_MIN_SAMPLES samples over TEMP_LEARN_MIN_SPAN_X100.
+#ifndef TEMP_COMPENSATION
+#define TEMP_COMPENSATION (MUX_SCAN_PARALLEL && !MUX_SCAN_PIO)
+#endif
+#if TEMP_COMPENSATION && (!MUX_SCAN_PARALLEL || MUX_SCAN_PIO)
+#error "TEMP_COMPENSATION needs the parallel CPU scan (MUX_SCAN_PARALLEL, no MUX_SCAN_PIO)"
+#endif
+#ifndef TEMP_SAMPLE_MS
+#define TEMP_SAMPLE_MS 2000
+#endif
+#ifndef TEMP_STEP_X100
+#define TEMP_STEP_X100 25
+#endif
+#ifndef TEMP_SENSITIVITY_PPM_PER_C
+#define TEMP_SENSITIVITY_PPM_PER_C 0
+#endif
+#ifndef TEMP_LEARN_MIN_SAMPLES
+#define TEMP_LEARN_MIN_SAMPLES 16
+#endif
+#ifndef TEMP_LEARN_MIN_SPAN_X100
+#define TEMP_LEARN_MIN_SPAN_X100 300
+#endif
 
+// Inline scans are started so they finish this long before the next USB
+// start-of-frame (see scan_governor_due in mux_adc.c).
+#ifndef SCAN_GOVERNOR_GUARD_US
+#define SCAN_GOVERNOR_GUARD_US 50
+#endif
+
+// Measure each address's settle time at boot instead of always waiting
+// MUX_SETTLE_US (parallel CPU scan only; the PIO engine has its own wait).
+// Budget = time to come within MUX_SETTLE_TOLERANCE counts, scaled from the
+// measured step to a full-scale one, + the margin; never below
+// MUX_SETTLE_MIN_US nor above MUX_SETTLE_US.
+#ifndef MUX_SETTLE_ADAPTIVE
+#define MUX_SETTLE_ADAPTIVE (MUX_SCAN_PARALLEL && !MUX_SCAN_PIO)
+#endif
+#if MUX_SETTLE_ADAPTIVE && (!MUX_SCAN_PARALLEL || MUX_SCAN_PIO)
+#error "MUX_SETTLE_ADAPTIVE needs the parallel CPU scan (MUX_SCAN_PARALLEL, no MUX_SCAN_PIO)"
+#endif
+// Reorder the parallel scan's addresses at boot so consecutive ones sit at
+// similar resting levels (smaller steps settle faster). Runs before the
+// settle measurement; the step sum before/after goes to the debug UART.
+#ifndef MUX_SCAN_ORDER_OPTIMIZE
+#define MUX_SCAN_ORDER_OPTIMIZE (MUX_SCAN_PARALLEL && !MUX_SCAN_PIO)
+#endif
+#if MUX_SCAN_ORDER_OPTIMIZE && (!MUX_SCAN_PARALLEL || MUX_SCAN_PIO)
+#error "MUX_SCAN_ORDER_OPTIMIZE needs the parallel CPU scan (MUX_SCAN_PARALLEL, no MUX_SCAN_PIO)"
+#endif
+// Priority scheduling for the parallel CPU scan: addresses carrying a hot
+// key are sampled every pass, the rest SCAN_COLD_SLICE addresses per pass in
+// rotation, so a cold key is at most mux_scan_cold_interval() passes old.
+// SCAN_HOT_KEYS (KeyName values from mux_pins.h) is the boot-time hot set;
+// raw HID can change it.
+#ifndef MUX_SCAN_PRIORITY
+#define MUX_SCAN_PRIORITY 0
+#endif
+#if MUX_SCAN_PRIORITY && (!MUX_SCAN_PARALLEL || MUX_SCAN_PIO)
+#error "MUX_SCAN_PRIORITY needs the parallel CPU scan (MUX_SCAN_PARALLEL, no MUX_SCAN_PIO)"
+#endif
+#ifndef SCAN_COLD_SLICE
+#define SCAN_COLD_SLICE 4
+#endif
+#ifndef SCAN_HOT_KEYS
+#define SCAN_HOT_KEYS K_W, K_A, K_S, K_D, K_SPACE, K_LSHIFT, K_LCTRL
+#endif
+#ifndef MUX_SETTLE_TOLERANCE
+#define MUX_SETTLE_TOLERANCE 2
+#endif
+#ifndef MUX_SETTLE_MARGIN_US
+#define MUX_SETTLE_MARGIN_US 10
+#endif
+#ifndef MUX_SETTLE_MIN_US
+#define MUX_SETTLE_MIN_US 5
+#endif
+
+// Adaptive oversampling: an address holding a key whose last travel sat
+// within MUX_OVERSAMPLE_MARGIN (ANALOG_TRAVEL units) of its next decision
+// point is converted MUX_OVERSAMPLE_COUNT times back to back and averaged;
+// the other addresses stay single-sample. CPU scans only.
+#ifndef MUX_SCAN_OVERSAMPLE
+#define MUX_SCAN_OVERSAMPLE 0
+#endif
+#if MUX_SCAN_OVERSAMPLE && MUX_SCAN_PIO
+#error "MUX_SCAN_OVERSAMPLE needs a CPU scan (no MUX_SCAN_PIO)"
+#endif
+#ifndef MUX_OVERSAMPLE_COUNT
+#define MUX_OVERSAMPLE_COUNT 4
+#endif
+#ifndef MUX_OVERSAMPLE_MARGIN
+#define MUX_OVERSAMPLE_MARGIN (ANALOG_TRAVEL_FULL / 16)
+#endif
+
+// Raw RP2040 ADC results are 12-bit; shift down to the 10-bit scale that
+// analogReadPin returns so thresholds and calibration values stay the same.
+#ifndef MUX_ADC_RESULT_SHIFT
+#define MUX_ADC_RESULT_SHIFT 2
+#endif
+
+// RP2040 ADC differential nonlinearity: the 12-bit codes 512, 1536, 2560
+// and 3584 are about ADC_DNL_EXTRA_LSB wider than the others, so every code
+// above one of them reads that much low. The correction maps each raw code
+// to the middle of the input range it stands for and rescales so the full
+// range still spans 4096 codes (mid-scale, where keys rest, barely moves).
+// Applied where raw 12-bit codes are read: the parallel scan's round-robin
+// reads (oversampled too), the PIO engine's samples and the temperature
+// sensor. The serial scan (MUX_SCAN_PARALLEL 0) reads analogReadPin's
+// 10-bit results, where the wide codes are already merged with their
+// neighbours, so it stays uncorrected.
+#ifndef ADC_DNL_CORRECTION
+#define ADC_DNL_CORRECTION 1
+#endif
+#ifndef ADC_DNL_EXTRA_LSB
+#define ADC_DNL_EXTRA_LSB 8
+#endif
+#define ADC_DNL_SCALE_Q16 ((uint32_t)((4096ul << 16) / (4096 + 4 * ADC_DNL_EXTRA_LSB)))
+
+// Corrected value of a raw 12-bit conversion (unchanged without ADC_DNL_CORRECTION)
+static inline uint16_t adc_correct_dnl(uint16_t raw) {
+#if ADC_DNL_CORRECTION
+    uint32_t wide_below = (raw + 511u) >> 10;     // wide codes under raw
+    uint32_t on_wide = (raw & 1023u) == 512u;     // raw is one of them
+    uint32_t ideal = raw + wide_below * ADC_DNL_EXTRA_LSB + on_wide * (ADC_DNL_EXTRA_LSB / 2);
+    return (uint16_t)((ideal * ADC_DNL_SCALE_Q16 + 0x8000u) >> 16);
+#else
+    return raw;
+#endif
+}
+
+// Add 0..MUX_SETTLE_DITHER_US of pseudo-random extra settle time per
+// address, so repeated readings of a steady input (calibration averages,
+// oversampling) spread over the sensor noise instead of locking onto the
+// same codes. 0 = fixed settle time.
+#ifndef MUX_SETTLE_DITHER_US
+#define MUX_SETTLE_DITHER_US 0
+#endif
 
 // QMK Matrix functions
 void matrix_init_custom(void);
 bool matrix_scan_custom(matrix_row_t current_matrix[]);
 
-// Auto-calibration function
+// Auto-calibration: load the stored calibration, or measure and store one
 void calibrate_sensors(void);
 
+// Measure baselines again and store them. Returns at once; matrix_scan_custom
+// takes the samples between scans, and keys must stay released until
+// mux_recalibrating() goes false.
+void recalibrate_sensors(void);
+bool mux_recalibrating(void);
+
+// Start (true) or finish (false) capturing each key's bottom-out travel
+void capture_bottom_out(bool start);
+
+// Start (true) or finish (false) measuring crosstalk coefficients: hold
+// each key down alone for a moment; keys never held keep their old ones
+void capture_crosstalk(bool start);
+
 // Set a per-key sensitivity percent by key index
 // percent: sensitivity percent (e.g., 10 => trigger when value deviates +/-10% from baseline)
 void set_key_threshold(uint16_t key_idx, uint8_t percent);
 
+// Full-board scan passes per second, refreshed once a second
+uint32_t mux_scan_rate(void);
+
+// Scan pipeline counters over the last full second. Packed: raw HID sends
+// it as is (little endian).
+typedef struct __attribute__((packed)) {
+    uint32_t passes_per_s;
+    uint16_t pass_us_min;      // pass = sample every key + evaluate + publish
+    uint16_t pass_us_avg;
+    uint16_t pass_us_max;
+    uint32_t settle_us_per_s;  // time spent waiting for mux outputs to settle
+    uint32_t adc_us_per_s;     // time spent in ADC conversions
+    uint16_t invalid_per_s;    // samples over the valid range (read as 4095)
+    uint16_t spikes_per_s;     // samples replaced by the spike filter
+    uint16_t changes_per_s;    // committed key state changes
+    uint16_t predicted_per_s;  // presses committed early by prediction
+    uint16_t predict_false_per_s;  // of those, released before actuation
+    uint16_t oversampled_per_s;    // key samples averaged from several conversions
+} mux_scan_stats_t;
+
+void mux_scan_stats(mux_scan_stats_t *stats);
+
+// Board temperature and warm-up fit progress. Packed: raw HID sends it as is.
+typedef struct __attribute__((packed)) {
+    int16_t now_x100;          // smoothed RP2040 temperature, 0.01 degC
+    int16_t ref_x100;          // temperature the stored baselines belong to
+    uint8_t learning;          // warm-up fit running
+    uint16_t learn_samples;    // samples in the fit so far
+    uint16_t learn_span_x100;  // temperature range they cover
+} mux_temperature_t;
+
+void mux_temperature(mux_temperature_t *temp);
+
+// Warm-up calibration of the temperature slopes: start (true) with the
+// board cold and hands off, let it warm up (LEDs on), then stop (false) to
+// fit each key's resting value against temperature and store the result
+void learn_temperature(bool start);
+
+// time_us_64() of the sample behind a key's latest matrix change
+uint64_t mux_key_change_us(uint8_t row, uint8_t col);
+
+// Set a key's sensitivity in multiples of its noise (0 = sensitivity percent)
+void set_key_sensitivity_sigma(uint16_t key_idx, uint8_t multiple);
+
+// Measured resting noise of a key (standard deviation, ADC counts x16)
+uint16_t get_key_noise_x16(uint16_t key_idx);
+
+// Oversampled samples of a key over the last full second (MUX_SCAN_OVERSAMPLE)
+uint16_t get_key_oversamples(uint16_t key_idx);
+
+// Set a key's actuation/reset points in 0.01 mm (actuation 0 = sensitivity percent)
+void set_key_actuation(uint16_t key_idx, uint16_t actuation_mm_x100, uint16_t reset_mm_x100);
+
+// Set a key's rapid trigger mode and press/release deltas (0.01 mm, 0 = unchanged)
+void set_key_rapid_trigger(uint16_t key_idx, uint8_t mode, uint8_t press_mm_x100, uint8_t release_mm_x100);
+
+#if KEY_PREDICTIVE_ACTUATION
+// Lead of predictive actuation in percent of a sample interval (0 = off)
+void set_predictive_lead(uint8_t percent);
+#endif
+
+#if MUX_SCAN_PRIORITY
+// Make a key hot (sampled every pass) or cold (sampled in rotation)
+void set_key_priority(uint16_t key_idx, bool hot);
+
+// Worst-case age of a cold key's sample, in passes
+uint8_t mux_scan_cold_interval(void);
+#endif
+
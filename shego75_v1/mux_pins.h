@@ -38,9 +38,61 @@ typedef struct {
 
 
 
+// ADG732 wiring: X(channel, mux, key) for every wired input, one row per
+// address (A0..A4) with MUX1/MUX2/MUX3 in columns; unwired inputs are left
+// out. This is the single source for the scan plan and the per-mux tables,
+// and mux_pins.c checks at compile time that each KeyName appears once.
+#define MUX_WIRING(X) \
+    X( 0, 1, K_F3)        X( 0, 2, K_F7)        X( 0, 3, K_DEL)               \
+    X( 1, 1, K_3)         X( 1, 2, K_7)         X( 1, 3, K_F12)               \
+    X( 2, 1, K_F2)        X( 2, 2, K_F6)        X( 2, 3, K_F11)               \
+    X( 3, 1, K_F1)        X( 3, 2, K_6)         X( 3, 3, K_F10)               \
+    X( 4, 1, K_2)         X( 4, 2, K_Y)                                       \
+    X( 5, 1, K_ESC)       X( 5, 2, K_8)         X( 5, 3, K_F9)                \
+    X( 6, 1, K_W)                                                             \
+    X( 7, 1, K_F4)        X( 7, 2, K_F5)        X( 7, 3, K_F8)                \
+    X( 8, 1, K_1)         X( 8, 2, K_T)                                       \
+    X( 9, 1, K_GRAVE)     X( 9, 2, K_N)         X( 9, 3, K_EQUAL)             \
+    X(10, 1, K_Q)         X(10, 2, K_M)                                       \
+    X(11, 1, K_TAB)       X(11, 2, K_RALT)      X(11, 3, K_RBRC)              \
+    X(12, 1, K_CAPS)      X(12, 2, K_COMMA)     X(12, 3, K_L)                 \
+    X(13, 1, K_LSHIFT)    X(13, 2, K_H)         X(13, 3, K_SEMI)              \
+    X(14, 1, K_A)                               X(14, 3, K_QUOTE)             \
+    X(15, 1, K_LCTRL)                           X(15, 3, K_SLASH)             \
+    X(16, 1, K_E)         X(16, 2, K_U)         X(16, 3, K_HOME)              \
+    X(17, 1, K_4)         X(17, 2, K_I)         X(17, 3, K_PGUP)              \
+    X(18, 1, K_R)         X(18, 2, K_9)         X(18, 3, K_PGDN)              \
+    X(19, 1, K_5)         X(19, 2, K_O)                                       \
+    X(20, 1, K_G)         X(20, 2, K_0)         X(20, 3, K_RIGHT)             \
+    X(21, 1, K_B)         X(21, 2, K_P)                                       \
+    X(22, 1, K_F)         X(22, 2, K_MINUS)     X(22, 3, K_UP)                \
+    X(23, 1, K_SPACE)     X(23, 2, K_LBRC)                                    \
+    X(24, 1, K_D)                               X(24, 3, K_DOWN)              \
+    X(25, 1, K_V)         X(25, 2, K_K)         X(25, 3, K_BSLASH)            \
+    X(26, 1, K_C)         X(26, 2, K_DOT)       X(26, 3, K_ENTER)             \
+    X(27, 1, K_LALT)      X(27, 2, K_J)         X(27, 3, K_BACKSPACE)         \
+    X(28, 1, K_LWIN)                            X(28, 3, K_LEFT)              \
+    X(29, 1, K_X)                               X(29, 3, K_RCTRL)             \
+    X(30, 1, K_Z)                               X(30, 3, K_RSHIFT)            \
+    X(31, 1, K_S)                               X(31, 3, K_FN)                \
+    /* end of wiring */
+
+// One wired mux input in scan order
+typedef struct {
+    uint8_t channel;   // ADG732 address (A0..A4)
+    uint8_t mux;       // 0..2 = MUX1..MUX3
+    uint8_t key_idx;   // row * MATRIX_COLS + col
+    uint8_t row;       // matrix row
+    uint16_t col_bit;  // 1 << matrix col
+} scan_plan_entry_t;
+
+#define SCAN_PLAN_LEN KEY_COUNT
+
 // Extern declarations for each MUX table
 extern const char *sensor_names[KEY_COUNT];
 extern const uint16_t sensor_to_keycode[KEY_COUNT];
-extern const mux32_ref_t mux1_channels[33];
-extern const mux32_ref_t mux2_channels[33];
-extern const mux32_ref_t mux3_channels[33];
+extern const mux32_ref_t mux_channels[3][33];
+#define mux1_channels (mux_channels[0])
+#define mux2_channels (mux_channels[1])
+#define mux3_channels (mux_channels[2])
+extern const scan_plan_entry_t scan_plan[SCAN_PLAN_LEN];
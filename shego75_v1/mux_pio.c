@@ -0,0 +1,319 @@
+// mux_pio.c - PIO sequenced mux scan with DMA-paced ADC sampling
+//
+// PIO program (side-set = WR, out pins = A0..A4, X = address, OSR = token):
+//
+//     set x, 31            side 1      ; wrap target: start a new pass
+// addr:
+//     mov pins, x          side 1      ; A0..A4 = address
+//     nop                  side 0 [7]  ; WR low 1us latches all three ADG732s
+//     <settle>             side 1      ; set y,n / jmp y-- [15] loops
+//     mov isr, osr         side 1      ; token = ADC_CS_START_ONCE
+//     push block           side 1 [15] ; -> DMA -> ADC CS: convert MUX1
+//     mov isr, osr         side 1
+//     push block           side 1 [15] ; MUX2 (round-robin advanced AINSEL)
+//     mov isr, osr         side 1
+//     push block           side 1 [15] ; MUX3, hold address until it's done
+//     jmp x-- addr         side 1      ; wrap
+//
+// DMA channels:
+//   trig        PIO RX FIFO -> ADC CS (atomic set alias), 96 per pass
+//   trig_ctrl   re-arms trig's transfer count after each pass
+//   sample      ADC FIFO -> sample buffer, 96 per pass
+//   sample_ctrl points sample at the other buffer after each pass
+//
+// Addresses run 31..0, so sample i belongs to address 31 - i/3, mux i%3.
+// Pushes block, so a token is never dropped at the PIO; the ADC ignoring a
+// start is caught by the alignment check after each pass (restart).
+#include QMK_KEYBOARD_H
+#include "mux_pio.h"
+#include "mux_adc.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/adc.h"
+#include "hardware/clocks.h"
+#include "hardware/timer.h"
+#include "hardware/address_mapped.h"
+#include "pico/platform.h"
+#include <string.h>
+
+#ifndef MUX_PIO_BLOCK
+#define MUX_PIO_BLOCK pio1  // pio0 is used by the WS2812 driver
+#endif
+
+#define PIO_SIDE(v) pio_encode_sideset(1, (v))
+#define PIO_CONV_DELAY (MUX_PIO_CONV_CYCLES - 2)  // push + delay + next mov
+_Static_assert(PIO_CONV_DELAY <= 15, "MUX_PIO_CLK_HZ too high for the conversion spacing delay");
+#define PIO_MAX_SETTLE_LOOPS 8
+
+static uint16_t pio_samples[2][MUX_PIO_SAMPLES] __attribute__((aligned(4)));
+// sample_ctrl walks this list with an 8-byte read ring, alternating buffers
+static uint16_t *pio_sample_bufs[2] __attribute__((aligned(8)));
+// trig_ctrl reads this every pass, flash writes included: keep it in RAM
+static uint32_t trig_count_reload = MUX_PIO_SAMPLES;
+
+static uint16_t pio_instructions[32];
+static uint program_offset;
+static uint sm;
+static const rp_dma_channel_t *dma_channels[4];
+static uint dma_trig, dma_trig_ctrl, dma_sample, dma_sample_ctrl;
+static dma_channel_config trig_config, sample_config;
+static uint8_t last_active = 0;
+static bool pio_running = false;
+
+// Build the program; settle loops are generated from MUX_PIO_SETTLE_US
+static uint8_t build_program(void) {
+    uint8_t n = 0;
+    uint32_t settle = (uint32_t)MUX_PIO_SETTLE_US * (MUX_PIO_CLK_HZ / 1000000);
+
+    pio_instructions[n++] = pio_encode_set(pio_x, 31) | PIO_SIDE(1);
+    uint8_t addr = n;
+    pio_instructions[n++] = pio_encode_mov(pio_pins, pio_x) | PIO_SIDE(1);
+    pio_instructions[n++] = pio_encode_nop() | PIO_SIDE(0) | pio_encode_delay(7);
+
+    for (uint8_t loop = 0; loop < PIO_MAX_SETTLE_LOOPS && settle > 16; loop++) {
+        // set y,k + (k+1) x 16-cycle jmp = 1 + 16(k+1) cycles
+        uint32_t iters = (settle - 1) / 16;
+        if (iters > 32) iters = 32;
+        pio_instructions[n++] = pio_encode_set(pio_y, iters - 1) | PIO_SIDE(1);
+        pio_instructions[n] = pio_encode_jmp_y_dec(n) | PIO_SIDE(1) | pio_encode_delay(15);
+        n++;
+        settle -= 1 + iters * 16;
+    }
+    if (settle > 16) settle = 16;  // out of program space: cap the remainder
+    if (settle > 0) {
+        pio_instructions[n++] = pio_encode_nop() | PIO_SIDE(1) | pio_encode_delay(settle - 1);
+    }
+
+    for (uint8_t mux = 0; mux < 3; mux++) {
+        pio_instructions[n++] = pio_encode_mov(pio_isr, pio_osr) | PIO_SIDE(1);
+        pio_instructions[n++] = pio_encode_push(false, true) | PIO_SIDE(1) | pio_encode_delay(PIO_CONV_DELAY);
+    }
+    pio_instructions[n++] = pio_encode_jmp_x_dec(addr) | PIO_SIDE(1);
+    return n;
+}
+
+static void release_dma_channels(void) {
+    for (uint8_t i = 0; i < 4; i++) {
+        if (dma_channels[i]) {
+            dmaChannelFree(dma_channels[i]);
+            dma_channels[i] = NULL;
+        }
+    }
+}
+
+// The four DMA channels, or none (false) if any is unavailable
+static bool claim_dma_channels(void) {
+    for (uint8_t i = 0; i < 4; i++) {
+        dma_channels[i] = dmaChannelAlloc(RP_DMA_CHANNEL_ID_ANY, RP_IRQ_DMA0_PRIORITY, NULL, NULL);
+        if (!dma_channels[i]) {
+            release_dma_channels();
+            return false;
+        }
+    }
+    dma_trig = dma_channels[0]->chnidx;
+    dma_trig_ctrl = dma_channels[1]->chnidx;
+    dma_sample = dma_channels[2]->chnidx;
+    dma_sample_ctrl = dma_channels[3]->chnidx;
+    return true;
+}
+
+// Start a pass at address 31 with both DMA streams at the start of buffer 0.
+// The state machine must be stopped and the DMA channels idle.
+static void engine_start(void) {
+    PIO pio = MUX_PIO_BLOCK;
+
+    // Let a conversion still under way finish, then start clean on MUX1
+    while (!(adc_hw->cs & ADC_CS_READY_BITS)) {
+    }
+    adc_fifo_drain();
+    adc_select_input(0);
+
+    pio_sm_clear_fifos(pio, sm);
+    pio_sm_restart(pio, sm);
+    pio_sm_exec(pio, sm, pio_encode_jmp(program_offset));
+    // Preload OSR with the ADC start token; the program never pulls again
+    pio_sm_put(pio, sm, ADC_CS_START_ONCE_BITS);
+    pio_sm_exec(pio, sm, pio_encode_pull(false, true));
+
+    dma_channel_set_config(dma_trig, &trig_config, false);
+    dma_channel_set_config(dma_sample, &sample_config, false);
+    dma_channel_set_trans_count(dma_trig, MUX_PIO_SAMPLES, false);
+    dma_channel_set_read_addr(dma_sample_ctrl, pio_sample_bufs, false);
+
+    // sample_ctrl's first transfer points sample at buffer 0 and starts it
+    dma_start_channel_mask((1u << dma_sample_ctrl) | (1u << dma_trig));
+    last_active = 0;
+    pio_sm_set_enabled(pio, sm, true);
+}
+
+static void engine_stop(void) {
+    const uint32_t mask = (1u << dma_trig) | (1u << dma_trig_ctrl) | (1u << dma_sample) | (1u << dma_sample_ctrl);
+
+    pio_sm_set_enabled(MUX_PIO_BLOCK, sm, false);
+    // Unchain the data channels so an abort cannot re-arm them, then abort
+    dma_channel_config cfg = trig_config;
+    channel_config_set_chain_to(&cfg, dma_trig);
+    dma_channel_set_config(dma_trig, &cfg, false);
+    cfg = sample_config;
+    channel_config_set_chain_to(&cfg, dma_sample);
+    dma_channel_set_config(dma_sample, &cfg, false);
+    dma_hw->abort = mask;
+    while (dma_hw->abort & mask) {
+    }
+}
+
+bool mux_pio_init(void) {
+    PIO pio = MUX_PIO_BLOCK;
+
+    // Program + state machine; give up before touching the pins if the
+    // engine cannot get everything it needs
+    pio_program_t program = {
+        .instructions = pio_instructions,
+        .length = build_program(),
+        .origin = -1,
+    };
+    if (!claim_dma_channels()) {
+        return false;
+    }
+    int claimed = pio_claim_unused_sm(pio, false);
+    if (claimed < 0 || !pio_can_add_program(pio, &program)) {
+        if (claimed >= 0) pio_sm_unclaim(pio, (uint)claimed);
+        release_dma_channels();
+        return false;
+    }
+    sm = (uint)claimed;
+    program_offset = pio_add_program(pio, &program);
+
+    // All three muxes latch every address, so CS stays low for the engine's life
+    setPinOutput(MUX_CS1);
+    setPinOutput(MUX_CS2);
+    setPinOutput(MUX_CS3);
+    writePinLow(MUX_CS1);
+    writePinLow(MUX_CS2);
+    writePinLow(MUX_CS3);
+
+    for (uint pin = MUX_A0; pin <= MUX_A4; pin++) {
+        pio_gpio_init(pio, pin);
+    }
+    pio_gpio_init(pio, MUX_WR);
+    pio_sm_set_consecutive_pindirs(pio, sm, MUX_A0, 5, true);
+    pio_sm_set_consecutive_pindirs(pio, sm, MUX_WR, 1, true);
+    pio_sm_set_pins_with_mask(pio, sm, 1u << MUX_WR, 1u << MUX_WR);
+
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, program_offset, program_offset + program.length - 1);
+    sm_config_set_out_pins(&c, MUX_A0, 5);
+    sm_config_set_sideset(&c, 1, false, false);
+    sm_config_set_sideset_pins(&c, MUX_WR);
+    sm_config_set_clkdiv(&c, (float)clock_get_hz(clk_sys) / MUX_PIO_CLK_HZ);
+    pio_sm_init(pio, sm, program_offset, &c);
+
+    // ADC: round-robin over inputs 0..2, results into the FIFO with DREQ
+    adc_set_round_robin(0x07);
+    adc_fifo_setup(true, true, 1, false, false);
+
+    pio_sample_bufs[0] = pio_samples[0];
+    pio_sample_bufs[1] = pio_samples[1];
+
+    // sample: ADC FIFO -> buffer, chains to sample_ctrl to swap buffers
+    dma_channel_config cfg = dma_channel_get_default_config(dma_sample);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, true);
+    channel_config_set_dreq(&cfg, DREQ_ADC);
+    channel_config_set_chain_to(&cfg, dma_sample_ctrl);
+    dma_channel_configure(dma_sample, &cfg, pio_samples[0], &adc_hw->fifo, MUX_PIO_SAMPLES, false);
+    sample_config = cfg;
+
+    // sample_ctrl: next buffer address -> sample's write address (trigger)
+    cfg = dma_channel_get_default_config(dma_sample_ctrl);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_ring(&cfg, false, 3);
+    dma_channel_configure(dma_sample_ctrl, &cfg, &dma_hw->ch[dma_sample].al2_write_addr_trig, pio_sample_bufs, 1, false);
+
+    // trig: PIO tokens -> ADC CS set alias (only START_ONCE gets set)
+    cfg = dma_channel_get_default_config(dma_trig);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, pio_get_dreq(pio, sm, false));
+    channel_config_set_chain_to(&cfg, dma_trig_ctrl);
+    dma_channel_configure(dma_trig, &cfg, hw_set_alias(&adc_hw->cs), &pio->rxf[sm], MUX_PIO_SAMPLES, false);
+    trig_config = cfg;
+
+    // trig_ctrl: rewrite trig's count (trigger alias) so it runs forever
+    cfg = dma_channel_get_default_config(dma_trig_ctrl);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, false);
+    dma_channel_configure(dma_trig_ctrl, &cfg, &dma_hw->ch[dma_trig].al1_transfer_count_trig, &trig_count_reload, 1, false);
+
+    engine_start();
+    pio_running = true;
+    return true;
+}
+
+// Buffer the sample channel is currently filling
+static inline uint8_t active_buffer(void) {
+    uintptr_t wr = (uintptr_t)dma_hw->ch[dma_sample].write_addr;
+    uintptr_t b1 = (uintptr_t)pio_samples[1];
+    return (wr >= b1 && wr <= b1 + sizeof(pio_samples[1])) ? 1 : 0;
+}
+
+// Whether every start token issued this pass is collected or still in the
+// ADC (mux_pio_streams_aligned). Counts are read on both sides of the ADC
+// state and the read is retried until neither moved in between.
+static bool streams_in_step(void) {
+    const uint32_t wait_cycles = (uint32_t)((uint64_t)clock_get_hz(clk_sys) * MUX_PIO_CHECK_WAIT_NS / 1000000000u);
+    uint32_t trig, sample, in_adc, cs;
+    do {
+        trig = dma_hw->ch[dma_trig].transfer_count;
+        sample = dma_hw->ch[dma_sample].transfer_count;
+        busy_wait_at_least_cycles(wait_cycles);
+        cs = adc_hw->cs;
+        in_adc = ((adc_hw->fcs & ADC_FCS_LEVEL_BITS) >> ADC_FCS_LEVEL_LSB) + !(cs & ADC_CS_READY_BITS);
+    } while (((cs ^ adc_hw->cs) & ADC_CS_READY_BITS) || trig != dma_hw->ch[dma_trig].transfer_count ||
+             sample != dma_hw->ch[dma_sample].transfer_count);
+    return mux_pio_streams_aligned(trig, sample, in_adc);
+}
+
+// Wait for the next completed pass and copy it; false (frame untouched)
+// if none completes within MUX_PIO_PASS_TIMEOUT_US
+static bool copy_pass(uint16_t frame[3][32]) {
+    // A completed pass shows up as the active buffer flipping
+    uint32_t start = time_us_32();
+    uint8_t active;
+    while ((active = active_buffer()) == last_active) {
+        if (time_us_32() - start > MUX_PIO_PASS_TIMEOUT_US) {
+            return false;
+        }
+    }
+
+    do {
+        active = active_buffer();
+        const uint16_t *done = pio_samples[active ^ 1];
+        for (uint8_t i = 0; i < MUX_PIO_SAMPLES; i++) {
+            frame[MUX_PIO_SAMPLE_MUX(i)][MUX_PIO_SAMPLE_ADDRESS(i)] = adc_correct_dnl(done[i]) >> MUX_ADC_RESULT_SHIFT;
+        }
+        // Retry if the engine moved on to the buffer we were copying
+    } while (active_buffer() != active);
+
+    last_active = active;
+    return true;
+}
+
+void mux_pio_read_frame(uint16_t frame[3][32]) {
+    if (!pio_running) return;
+
+    if (!copy_pass(frame) || !streams_in_step()) {
+        // The engine stalled, or samples are landing in the wrong slots
+        // (this pass too, most likely): restart from address 31 and use the
+        // first pass after. Should that stall as well, the last frame stays
+        // and the next call restarts again.
+        engine_stop();
+        engine_start();
+        copy_pass(frame);
+    }
+}
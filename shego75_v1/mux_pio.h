@@ -0,0 +1,68 @@
+/* mux_pio.h - free-running PIO + DMA mux/ADC scan engine (RP2040)
+ *
+ * A PIO state machine walks A0..A4, pulses WR and, after the settle time,
+ * emits three ADC start tokens per address. DMA moves each token into the
+ * ADC (round-robin over GP26..GP28) and moves every result into a
+ * double-buffered sample frame, so no CPU time is spent in the scan.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// PIO clock: one cycle = 125ns. All engine timings are counted in these cycles.
+#ifndef MUX_PIO_CLK_HZ
+#define MUX_PIO_CLK_HZ 8000000
+#endif
+
+// Settle time per address in the PIO engine. Each address costs roughly
+// 7.6us of WR pulse + 3 conversions plus this, so 0 gives ~4.1 kHz full-board
+// scans, 10 gives ~1.8 kHz and 100 gives ~290 Hz. A 4 kHz target needs 0,
+// which only suits boards whose muxes settle within the WR pulse.
+#ifndef MUX_PIO_SETTLE_US
+#define MUX_PIO_SETTLE_US 10
+#endif
+
+// A pass that has not completed after this long means the DMA chain stopped
+// (mux_pio_read_frame restarts the engine): four nominal passes
+#define MUX_PIO_PASS_TIMEOUT_US (4u * 32u * (8u + MUX_PIO_SETTLE_US))
+
+// PIO cycles between the three ADC start tokens of an address. A conversion
+// takes 96 ADC clocks (2us at 48 MHz) and a token that reaches the ADC while
+// it is still converting is ignored, so the spacing is 2us plus a cycle of
+// margin for the ADC to see the start.
+#define MUX_PIO_CONV_CYCLES ((MUX_PIO_CLK_HZ * 2 + 999999) / 1000000 + 1)
+
+// Samples in one full pass: 32 addresses x 3 muxes, address-major
+#define MUX_PIO_SAMPLES (32 * 3)
+
+// Addresses run 31..0, so sample i of a pass belongs to this mux and address
+#define MUX_PIO_SAMPLE_MUX(i) ((i) % 3)
+#define MUX_PIO_SAMPLE_ADDRESS(i) (31 - (i) / 3)
+
+// Stream alignment. trig_left and sample_left are the remaining transfer
+// counts of the DMA channel feeding start tokens to the ADC and the one
+// collecting results; in_adc is the conversions under way or waiting in the
+// ADC FIFO. In step, every token issued this pass is either collected or
+// still in the ADC. A token the ADC ignored leaves the results one slot
+// behind the addresses for good.
+static inline bool mux_pio_streams_aligned(uint32_t trig_left, uint32_t sample_left, uint32_t in_adc) {
+    return (sample_left + MUX_PIO_SAMPLES - trig_left) % MUX_PIO_SAMPLES == in_adc % MUX_PIO_SAMPLES;
+}
+
+// The alignment check reads both counts, waits this long so a token written
+// just before is converting, reads the ADC, and retries if a count moved
+#define MUX_PIO_CHECK_WAIT_NS 250
+
+// Claim PIO/DMA resources and start the free-running scan. Expects the ADC
+// to be initialized (adc_init + adc_gpio_init) and the mux pins configured.
+// Returns false, with nothing claimed and the pins untouched, when a state
+// machine, program space or DMA channel is not available.
+bool mux_pio_init(void);
+
+// Block until a pass newer than the last one read has completed, then copy
+// it as frame[mux][channel] (10-bit scale, unfiltered). If the streams are
+// found out of step afterwards, or no pass completes within
+// MUX_PIO_PASS_TIMEOUT_US, the engine restarts and the first pass after the
+// restart is returned instead (the previous frame stays if that stalls too).
+void mux_pio_read_frame(uint16_t frame[3][32]);
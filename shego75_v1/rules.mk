@@ -13,6 +13,12 @@ I2C_DRIVER_REQUIRED = yes  # Enable I2C for ESP32 communication
 # Use extended matrix scanning
 CUSTOM_MATRIX = lite
 SRC += mux_adc.c
+SRC += core1.c
+SRC += calibration.c
+SRC += analog_matrix.c
+SRC += key_events.c
+SRC += travel_lut.c
+SRC += mux_pio.c
 SRC += mux_pins.c
 SRC += uart.c
 SRC += uart_keycodes.c
@@ -24,6 +30,13 @@ SRC += i2c_esp32.c
 SRC += hid_reports.c
 SRC += vendor_bridge.c
 
+# EEPROM lives in wear-leveled flash. core1 runs the scanner from XIP flash,
+# so core1.c parks it around every backing-store write/erase: wrap the
+# driver's unlock/lock pair that brackets them
+EEPROM_DRIVER = wear_leveling
+WEAR_LEVELING_DRIVER = rp2040_flash
+EXTRALDFLAGS += -Wl,--wrap=backing_store_unlock -Wl,--wrap=backing_store_lock
+
 # Analog driver for RP2040
 ANALOG_DRIVER_REQUIRED = yes
 ANALOG_DRIVER = rp2040_adc
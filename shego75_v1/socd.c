@@ -19,6 +19,12 @@ static bool d_suppressed = false;
 static bool w_suppressed = false;
 static bool s_suppressed = false;
 
+// sample stamps of the latest presses
+static uint64_t a_time = 0;
+static uint64_t d_time = 0;
+static uint64_t w_time = 0;
+static uint64_t s_time = 0;
+
 void toggle_socd(void) {
     // Prevent rapid toggles (debounce) — ignore toggles within 1000 ms
     static uint32_t last_toggle_time = 0;
@@ -42,13 +48,25 @@ bool get_socd_enabled(void) {
 
 
 
-bool socd_process_key(uint16_t keycode, bool pressed) {
+// True if a press stamped `time` happened before the opposite key's press,
+// i.e. it only arrived second. Equal or missing stamps keep arrival order.
+static bool socd_pressed_earlier(uint64_t time, uint64_t opposite_time) {
+    return time && opposite_time && time < opposite_time;
+}
+
+bool socd_process_key(uint16_t keycode, bool pressed, uint64_t time_us) {
     // Only handle A/D/W/S
     if (keycode == KC_A) {
         if (pressed) {
             // A pressed now. Last input wins -> if D was down, suppress D and allow A
             a_pressed = true;
+            a_time = time_us;
             if (socd_enabled && d_pressed) {
+                if (!d_suppressed && socd_pressed_earlier(a_time, d_time)) {
+                    // A was pressed first but arrived second: D keeps winning
+                    a_suppressed = true;
+                    return false;
+                }
                 if (!d_suppressed) {
                     unregister_code(KC_D);
                     d_suppressed = true;
@@ -82,7 +100,13 @@ bool socd_process_key(uint16_t keycode, bool pressed) {
         if (pressed) {
             // D pressed now. Last input wins -> if A was down, suppress A and allow D
             d_pressed = true;
+            d_time = time_us;
             if (socd_enabled && a_pressed) {
+                if (!a_suppressed && socd_pressed_earlier(d_time, a_time)) {
+                    // D was pressed first but arrived second: A keeps winning
+                    d_suppressed = true;
+                    return false;
+                }
                 if (!a_suppressed) {
                     unregister_code(KC_A);
                     a_suppressed = true;
@@ -114,7 +138,13 @@ bool socd_process_key(uint16_t keycode, bool pressed) {
     if (keycode == KC_W) {
         if (pressed) {
             w_pressed = true;
+            w_time = time_us;
             if (socd_enabled && s_pressed) {
+                if (!s_suppressed && socd_pressed_earlier(w_time, s_time)) {
+                    // W was pressed first but arrived second: S keeps winning
+                    w_suppressed = true;
+                    return false;
+                }
                 if (!s_suppressed) {
                     unregister_code(KC_S);
                     s_suppressed = true;
@@ -146,7 +176,13 @@ bool socd_process_key(uint16_t keycode, bool pressed) {
     if (keycode == KC_S) {
         if (pressed) {
             s_pressed = true;
+            s_time = time_us;
             if (socd_enabled && w_pressed) {
+                if (!w_suppressed && socd_pressed_earlier(s_time, w_time)) {
+                    // S was pressed first but arrived second: W keeps winning
+                    s_suppressed = true;
+                    return false;
+                }
                 if (!w_suppressed) {
                     unregister_code(KC_W);
                     w_suppressed = true;
@@ -8,5 +8,7 @@ void toggle_socd(void);
 bool get_socd_enabled(void);
 
 // Process a key event for SOCD. Returns true to allow normal processing,
-// false to suppress the event.
-bool socd_process_key(uint16_t keycode, bool pressed);
+// false to suppress the event. time_us is the key's sample stamp
+// (mux_key_change_us): the later press of a pair wins even when QMK sees
+// both in the same scan, in matrix order. Pass 0 to go by arrival order.
+bool socd_process_key(uint16_t keycode, bool pressed, uint64_t time_us);
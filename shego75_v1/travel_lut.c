@@ -0,0 +1,62 @@
+// travel_lut.c - build per-key piecewise-linear travel curves
+// A hall sensor sees roughly B ~ 1/d^3 for magnet distance d, so equal
+// steps of signal are not equal steps of travel. With the gap g at
+// bottom-out and travel T, the normalized signal at travel x is
+//   s(x) = (1/(g+T-x)^3 - 1/(g+T)^3) / (1/g^3 - 1/(g+T)^3)
+// and the LUT stores x at evenly spaced s.
+#include "travel_lut.h"
+
+// Cube root by Newton's method (keeps libm out of the build)
+static float cube_root(float v) {
+    float y = v > 1.0f ? v : 1.0f;
+    for (uint8_t i = 0; i < 40; i++) {
+        y -= (y * y * y - v) / (3.0f * y * y);
+    }
+    return y;
+}
+
+// Gap at bottom-out that makes the field ratio bottom/rest come out as
+// measured: ((g+T)/g)^3 = ratio. A press moves the reading in the key's
+// polarity (away from quiescent while unknown). Falls back to the configured
+// gap when the rest reading is too close to quiescent to tell, or when the
+// press moves it towards quiescent (the field would have to shrink).
+static float estimate_gap(uint16_t rest, uint16_t bottom_out, int8_t polarity, float travel) {
+    int8_t away = (rest >= HALL_QUIESCENT) ? 1 : -1;
+    uint16_t rest_field = (rest > HALL_QUIESCENT) ? rest - HALL_QUIESCENT : HALL_QUIESCENT - rest;
+    float gap = KEY_MAGNET_GAP_MM_X100 / 100.0f;
+
+    if (rest_field >= 8 && (!polarity || polarity == away)) {
+        float ratio_root = cube_root((float)(rest_field + bottom_out) / rest_field);
+        if (ratio_root > 1.01f) {
+            gap = travel / (ratio_root - 1.0f);
+        }
+    }
+    if (gap < 0.2f) gap = 0.2f;
+    if (gap > 10.0f) gap = 10.0f;
+    return gap;
+}
+
+void travel_lut_linear(travel_lut_t *lut) {
+    for (uint8_t i = 0; i <= TRAVEL_LUT_SEGMENTS; i++) {
+        lut->point[i] = (uint16_t)i << TRAVEL_LUT_FRAC_SHIFT;
+    }
+    lut->point[TRAVEL_LUT_SEGMENTS + 1] = ANALOG_TRAVEL_FULL;
+}
+
+void travel_lut_build(travel_lut_t *lut, uint16_t rest, uint16_t bottom_out, int8_t polarity) {
+    float travel = KEY_TRAVEL_MM_X100 / 100.0f;
+    float gap = estimate_gap(rest, bottom_out, polarity, travel);
+    float field_rest = 1.0f / ((gap + travel) * (gap + travel) * (gap + travel));
+    float field_bottom = 1.0f / (gap * gap * gap);
+
+    for (uint8_t i = 0; i <= TRAVEL_LUT_SEGMENTS; i++) {
+        float s = (float)i / TRAVEL_LUT_SEGMENTS;
+        float distance = 1.0f / cube_root(s * (field_bottom - field_rest) + field_rest);
+        float x = (gap + travel - distance) / travel;
+
+        if (x < 0.0f) x = 0.0f;
+        if (x > 1.0f) x = 1.0f;
+        lut->point[i] = (uint16_t)(x * ANALOG_TRAVEL_FULL + 0.5f);
+    }
+    lut->point[TRAVEL_LUT_SEGMENTS + 1] = lut->point[TRAVEL_LUT_SEGMENTS];
+}
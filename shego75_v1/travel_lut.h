@@ -0,0 +1,54 @@
+/* travel_lut.h - per-key hall curve linearization */
+#pragma once
+
+#include <stdint.h>
+#include "analog_matrix.h"
+
+// Full key travel and the magnet-to-sensor gap at bottom-out, in 0.01 mm
+#ifndef KEY_TRAVEL_MM_X100
+#define KEY_TRAVEL_MM_X100 400
+#endif
+#ifndef KEY_MAGNET_GAP_MM_X100
+#define KEY_MAGNET_GAP_MM_X100 150
+#endif
+
+// Sensor output (10-bit counts) with no field; used to estimate each key's
+// magnet gap from how far its rest and bottom-out readings sit from it
+#ifndef HALL_QUIESCENT
+#define HALL_QUIESCENT 512
+#endif
+
+// 16 segments over the normalized signal (0..ANALOG_TRAVEL_FULL); the extra
+// last point repeats the end so a fully bottomed key needs no clamp
+#define TRAVEL_LUT_SEGMENT_SHIFT 4
+#define TRAVEL_LUT_SEGMENTS (1 << TRAVEL_LUT_SEGMENT_SHIFT)
+#define TRAVEL_LUT_POINTS (TRAVEL_LUT_SEGMENTS + 2)
+#define TRAVEL_LUT_FRAC_SHIFT (ANALOG_TRAVEL_SHIFT - TRAVEL_LUT_SEGMENT_SHIFT)
+
+// Maps normalized signal to linear travel, both in ANALOG_TRAVEL units
+typedef struct {
+    uint16_t point[TRAVEL_LUT_POINTS];
+} travel_lut_t;
+
+// Identity curve (used until a key is calibrated)
+void travel_lut_linear(travel_lut_t *lut);
+
+// Build the curve for a key from its rest value, bottom-out travel (ADC
+// counts) and polarity (1 = reading rises on press, -1 = falls, 0 =
+// unknown), assuming field ~ 1/distance^3. Float math; calibration time only.
+void travel_lut_build(travel_lut_t *lut, uint16_t rest, uint16_t bottom_out, int8_t polarity);
+
+// Linear travel for a normalized signal (0..ANALOG_TRAVEL_FULL). Integer
+// only, no branches: one segment lookup and an interpolation.
+static inline uint16_t travel_lut_eval(const travel_lut_t *lut, uint16_t signal) {
+    uint16_t seg = signal >> TRAVEL_LUT_FRAC_SHIFT;
+    uint16_t frac = signal & ((1 << TRAVEL_LUT_FRAC_SHIFT) - 1);
+    uint16_t lo = lut->point[seg];
+    return lo + (uint16_t)(((uint32_t)(lut->point[seg + 1] - lo) * frac) >> TRAVEL_LUT_FRAC_SHIFT);
+}
+
+// 0.01 mm <-> ANALOG_TRAVEL units
+static inline uint16_t travel_from_mm_x100(uint16_t mm_x100) {
+    uint32_t travel = ((uint32_t)mm_x100 * ANALOG_TRAVEL_FULL) / KEY_TRAVEL_MM_X100;
+    return travel > ANALOG_TRAVEL_FULL ? ANALOG_TRAVEL_FULL : (uint16_t)travel;
+}
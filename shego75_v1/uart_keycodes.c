@@ -3,6 +3,8 @@
 #include "uart.h"
 #include "wait.h"
 #include "lighting.h"
+#include "mux_adc.h"
+#include "key_events.h"
 #include <stdio.h>
 
 // Pin used to reset external ESP device (active low pulse)
@@ -121,6 +123,15 @@ bool led_pin_active_high(void) {
 
 bool process_record_user(uint16_t keycode, keyrecord_t *record) {
     bool pressed = record->event.pressed;
+    keypos_t pos = record->event.key;
+
+    // Microsecond stamp of the sample behind this change; logged here since
+    // the report for it is queued from this call
+    uint64_t sample_us = 0;
+    if (pos.row < MATRIX_ROWS && pos.col < MATRIX_COLS) {
+        sample_us = mux_key_change_us(pos.row, pos.col);
+        key_events_log(pos.row * MATRIX_COLS + pos.col, pressed, sample_us);
+    }
 
     if (pressed && get_raw_debug_enabled()) {
         // Print the raw keycode to debug UART (GP0)
@@ -132,7 +143,7 @@ bool process_record_user(uint16_t keycode, keyrecord_t *record) {
     // Delegate SOCD handling (WASD) to socd.c; if it returns false the event
     // should be suppressed.
     if (keycode == KC_A || keycode == KC_D || keycode == KC_W || keycode == KC_S) {
-        if (!socd_process_key(keycode, pressed)) return false;
+        if (!socd_process_key(keycode, pressed, sample_us)) return false;
     }
 
     // First, handle VIA user slots (QK_USER_0..3) directly so VIA works without extra mapping.
@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+"""Poll and display the keyboard's scan pipeline counters.
+
+Sends the GET_SCAN_STATS RawHID command (0x29) once per interval and prints
+the reply (mux_scan_stats_t in shego75_v1/mux_adc.h): pass rate and
+duration, time spent settling vs converting, rejected samples and key
+state changes (and predictive presses, with the false ones, and samples
+averaged by adaptive oversampling), all over the firmware's last full second.
+"""
+
+import argparse
+import struct
+import sys
+import time
+from typing import Optional
+
+import hid  # type: ignore
+
+RAW_USAGE_PAGE = 0xFF60
+RAW_USAGE = 0x61
+PAD_SIZE = 32
+APP_MAGIC = 0xA5
+CMD_GET_SCAN_STATS = 0x29
+
+# passes/s, pass us min/avg/max, settle us/s, adc us/s, invalid/s, spikes/s,
+# changes/s, predicted presses/s, false predicted presses/s, oversampled/s
+STATS_FORMAT = "<IHHHIIHHHHHH"
+STATS_SIZE = struct.calcsize(STATS_FORMAT)
+
+
+def open_device(path: Optional[str], vid: int, pid: int):
+    dev = hid.device()
+    if path:
+        target = path
+    else:
+        target = None
+        for entry in hid.enumerate(vid, pid):
+            if entry.get("usage_page") == RAW_USAGE_PAGE and entry.get("usage") == RAW_USAGE:
+                target = entry["path"]
+                break
+        if target is None:
+            raise RuntimeError("RawHID interface not found. Is RAW_ENABLE enabled?")
+    try:
+        dev.open_path(target)
+    except Exception:
+        dev.open_path(target.encode("utf-8") if isinstance(target, str) else target)
+    return dev
+
+
+def request_stats(dev, timeout_ms: int):
+    payload = [0x00, APP_MAGIC, CMD_GET_SCAN_STATS]
+    payload += [0] * (PAD_SIZE + 1 - len(payload))  # leading 0 is the HID report ID
+    dev.write(bytes(payload))
+
+    deadline = time.monotonic() + timeout_ms / 1000.0
+    while time.monotonic() < deadline:
+        data = dev.read(64, timeout_ms)
+        if data and data[0] == CMD_GET_SCAN_STATS:
+            if data[1] < STATS_SIZE:
+                raise RuntimeError(f"stats reply too short ({data[1]} < {STATS_SIZE} bytes)")
+            return struct.unpack_from(STATS_FORMAT, bytes(data), 2)
+    return None
+
+
+def show(stats) -> None:
+    passes, p_min, p_avg, p_max, settle_us, adc_us, invalid, spikes, changes, predicted, false_pred, oversampled = stats
+    busy = settle_us + adc_us
+    settle_pct = 100.0 * settle_us / busy if busy else 0.0
+    print(
+        f"{passes:6d} passes/s | pass us min/avg/max {p_min:5d}/{p_avg:5d}/{p_max:5d} | "
+        f"settle {settle_us / 1000:7.1f} ms/s ({settle_pct:4.1f}%) adc {adc_us / 1000:7.1f} ms/s | "
+        f"invalid {invalid:5d}/s spikes {spikes:5d}/s changes {changes:4d}/s | "
+        f"predicted {predicted:3d}/s false {false_pred:3d}/s | oversampled {oversampled:5d}/s"
+    )
+
+
+def main(argv) -> int:
+    parser = argparse.ArgumentParser(description="Display scan pipeline counters (RawHID 0x29)")
+    parser.add_argument("--path", help="Explicit HID device path", default=None)
+    parser.add_argument("--vid", default="DEAD")
+    parser.add_argument("--pid", default="C0DE")
+    parser.add_argument("--interval", type=float, default=1.0, help="Seconds between polls")
+    parser.add_argument("--once", action="store_true", help="Poll once and exit")
+    args = parser.parse_args(argv)
+
+    dev = open_device(args.path, int(args.vid, 16), int(args.pid, 16))
+    try:
+        while True:
+            stats = request_stats(dev, 500)
+            if stats is None:
+                print("no reply (is the vendor interface taking the response?)")
+            else:
+                show(stats)
+            if args.once:
+                break
+            time.sleep(args.interval)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        dev.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
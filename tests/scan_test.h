@@ -0,0 +1,49 @@
+/* scan_test.h - the scanner (mux_adc.c) built into a test, on sim/board.c
+ *
+ * Including mux_adc.c gives the test its static state and helpers; the
+ * helpers below drive the simulated board by key instead of mux input.
+ */
+#pragma once
+
+#include "../shego75_v1/mux_adc.c"
+#include "board.h"
+#include "test.h"
+
+// First scan plan entry of a key, NULL if it is not wired
+static inline const scan_plan_entry_t *plan_entry(uint8_t key_idx) {
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        if (scan_plan[i].key_idx == key_idx) return &scan_plan[i];
+    }
+    return NULL;
+}
+
+// Settled sensor level of a key, 10-bit counts
+static inline void sim_key_level(uint8_t key_idx, uint16_t level) {
+    const scan_plan_entry_t *e = plan_entry(key_idx);
+    sim_level[e->mux][e->channel] = level;
+}
+
+static inline bool matrix_key(const matrix_row_t matrix[], uint8_t key_idx) {
+    return matrix[key_idx / MATRIX_COLS] & (1u << (key_idx % MATRIX_COLS));
+}
+
+// Replay one pass through evaluate_frame with key_idx at `level` and every
+// other key at its resting value; returns whether key_idx is pressed
+static inline bool replay_pass(uint8_t key_idx, uint16_t level) {
+    static uint16_t frame[MAX_KEYS];
+    matrix_row_t matrix[MATRIX_ROWS];
+
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        frame[scan_plan[i].key_idx] = key_band[scan_plan[i].key_idx].base;
+    }
+    frame[key_idx] = level;
+    evaluate_frame(matrix, frame);
+    return matrix_key(matrix, key_idx);
+}
+
+// Power up the scanner: pins, ADC, calibration (measured with every key at
+// rest unless the EEPROM holds a record), core1 launch where configured
+static inline void scan_boot(void) {
+    matrix_init_custom();
+    calibrate_sensors();
+}
@@ -0,0 +1,250 @@
+/* board.c - simulated scan hardware for the host tests (see board.h) */
+#include "board.h"
+
+#include "quantum.h"
+#include "mux_adc.h"
+#include "core1.h"
+#include "hardware/adc.h"
+#include "hardware/timer.h"
+#include "hardware/regs/addressmap.h"
+#include "hardware/structs/scb.h"
+#include "hardware/structs/timer.h"
+#include <math.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+uint16_t sim_level[3][32];
+uint32_t sim_tau_ns[3][32];
+uint16_t sim_noise_12bit;
+uint16_t (*sim_adc_transfer)(uint16_t code);
+uint16_t sim_temp_raw;
+bool sim_usb_sof;
+
+uint32_t sim_usbctrl_regs[4];
+uint32_t sim_ppb_regs[0x4000];
+static timer_hw_t sim_timer;
+static scb_hw_t sim_scb;
+timer_hw_t *timer_hw = &sim_timer;
+scb_hw_t *scb_hw = &sim_scb;
+
+static uint64_t now_ns;
+static uint32_t timer_reads;
+
+static uint8_t pin_level[32];
+static uint8_t latched[3];
+static uint64_t latch_ns[3];
+static double latch_from[3];
+
+static unsigned adc_input;
+static unsigned adc_rr_mask;
+static uint32_t adc_conversions;
+static uint32_t noise_state = 0x12345678u;
+
+static uint8_t eeprom[EECONFIG_KB_DATA_SIZE];
+
+// ---- clock -----------------------------------------------------------------
+
+static uint64_t clock_add(uint64_t ns) {
+    uint64_t t = __atomic_add_fetch(&now_ns, ns, __ATOMIC_SEQ_CST);
+    sim_usbctrl_regs[2] = sim_usb_sof ? (uint32_t)(t / 1000000u) & 0x7ffu : 0;
+    return t;
+}
+
+uint64_t sim_time_ns(void) {
+    return __atomic_load_n(&now_ns, __ATOMIC_SEQ_CST);
+}
+
+void sim_advance_ns(uint64_t ns) {
+    clock_add(ns);
+}
+
+uint32_t time_us_32(void) {
+    // Two threads may spin on the clock; give the other one a turn now and then
+    if ((__atomic_add_fetch(&timer_reads, 1, __ATOMIC_RELAXED) & 0xff) == 0) {
+        sched_yield();
+    }
+    return (uint32_t)(clock_add(SIM_TIMER_READ_NS) / 1000u);
+}
+
+uint64_t time_us_64(void) {
+    return clock_add(SIM_TIMER_READ_NS) / 1000u;
+}
+
+void wait_us(uint32_t us) {
+    clock_add((uint64_t)us * 1000u);
+}
+
+void wait_ms(uint32_t ms) {
+    clock_add((uint64_t)ms * 1000000u);
+}
+
+uint32_t timer_read32(void) {
+    return (uint32_t)(sim_time_ns() / 1000000u);
+}
+
+uint32_t timer_elapsed32(uint32_t last) {
+    return timer_read32() - last;
+}
+
+// ---- muxes -----------------------------------------------------------------
+
+static double mux_output(uint8_t m, uint64_t t) {
+    double target = sim_level[m][latched[m]];
+    uint32_t tau = sim_tau_ns[m][latched[m]];
+    if (!tau) {
+        return target;
+    }
+    return target + (latch_from[m] - target) * exp(-(double)(t - latch_ns[m]) / tau);
+}
+
+static bool cs_low(uint8_t m) {
+    static const pin_t cs[3] = {MUX_CS1, MUX_CS2, MUX_CS3};
+    return !pin_level[cs[m]];
+}
+
+void writePin(pin_t pin, uint8_t level) {
+    uint64_t t = clock_add(SIM_GPIO_WRITE_NS);
+    bool rising = pin == MUX_WR && !pin_level[pin] && level;
+    pin_level[pin] = level ? 1 : 0;
+    if (!rising) {
+        return;
+    }
+    uint8_t address = (pin_level[MUX_A0] << 0) | (pin_level[MUX_A1] << 1) | (pin_level[MUX_A2] << 2) |
+                      (pin_level[MUX_A3] << 3) | (pin_level[MUX_A4] << 4);
+    for (uint8_t m = 0; m < 3; m++) {
+        if (cs_low(m)) {
+            latch_from[m] = mux_output(m, t);
+            latched[m] = address;
+            latch_ns[m] = t;
+        }
+    }
+}
+
+void writePinLow(pin_t pin) {
+    writePin(pin, 0);
+}
+
+void writePinHigh(pin_t pin) {
+    writePin(pin, 1);
+}
+
+void setPinOutput(pin_t pin) {}
+void setPinInput(pin_t pin) {}
+
+uint8_t readPin(pin_t pin) {
+    return pin_level[pin];
+}
+
+uint8_t sim_latched_address(uint8_t m) {
+    return latched[m];
+}
+
+// ---- ADC -------------------------------------------------------------------
+
+static uint16_t convert(unsigned input) {
+    // The sample is taken when the conversion starts
+    uint64_t t = sim_time_ns();
+    double v = 0;
+    if (input < 3) {
+        v = mux_output(input, t) * 4.0 + 2.0;  // middle of the 10-bit step
+    } else if (input == 4) {
+        v = sim_temp_raw;
+    }
+    if (sim_noise_12bit) {
+        noise_state ^= noise_state << 13;
+        noise_state ^= noise_state >> 17;
+        noise_state ^= noise_state << 5;
+        v += (double)(noise_state % (sim_noise_12bit + 1u)) - sim_noise_12bit / 2.0;
+    }
+    long code = lround(v);
+    code = (code < 0) ? 0 : (code > 4095) ? 4095 : code;
+    clock_add(SIM_ADC_CONVERSION_NS);
+    adc_conversions++;
+    return sim_adc_transfer ? sim_adc_transfer((uint16_t)code) : (uint16_t)code;
+}
+
+void adc_init(void) {}
+void adc_gpio_init(unsigned gpio) {}
+void adc_set_temp_sensor_enabled(bool enable) {}
+void adc_run(bool run) {}
+void adc_set_clkdiv(float div) {}
+void adc_fifo_setup(bool en, bool dreq_en, uint16_t dreq_thresh, bool err_in_fifo, bool byte_shift) {}
+void adc_fifo_drain(void) {}
+
+void adc_select_input(unsigned input) {
+    adc_input = input;
+}
+
+void adc_set_round_robin(unsigned mask) {
+    adc_rr_mask = mask;
+}
+
+uint16_t adc_read(void) {
+    uint16_t code = convert(adc_input);
+    if (adc_rr_mask) {
+        do {
+            adc_input = (adc_input + 1) % 5;
+        } while (!(adc_rr_mask & (1u << adc_input)));
+    }
+    return code;
+}
+
+uint16_t analogReadPin(pin_t pin) {
+    return convert(pin - MUX1_ADC_PIN) >> 2;  // QMK's rp2040_adc driver is 10-bit
+}
+
+uint32_t sim_adc_conversions(void) {
+    return adc_conversions;
+}
+
+// ---- everything else the firmware links against --------------------------
+
+void eeconfig_read_kb_datablock(void *data) {
+    memcpy(data, eeprom, sizeof(eeprom));
+}
+
+// Like the wear-leveling driver's writes, with core1 parked (core1.c)
+void eeconfig_update_kb_datablock(const void *data) {
+    core1_park_begin();
+    memcpy(eeprom, data, sizeof(eeprom));
+    core1_park_end();
+}
+
+void uart_send_string(const char *str) {
+    if (getenv("SIM_VERBOSE")) fputs(str, stdout);
+}
+
+void uart_debug_print(const char *str) {
+    uart_send_string(str);
+}
+
+bool get_adc_debug_enabled(void) {
+    return false;
+}
+
+void raw_hid_send(uint8_t *data, uint8_t length) {}
+
+void sim_reset(uint16_t level) {
+    sim_core1_stop();
+    for (uint8_t m = 0; m < 3; m++) {
+        for (uint8_t a = 0; a < 32; a++) {
+            sim_level[m][a] = level;
+            sim_tau_ns[m][a] = 0;
+        }
+        latched[m] = 0;
+        latch_ns[m] = 0;
+        latch_from[m] = level;
+    }
+    memset(pin_level, 1, sizeof(pin_level));
+    sim_noise_12bit = 0;
+    sim_adc_transfer = NULL;
+    sim_temp_raw = 876;  // about 21 degC
+    sim_usb_sof = false;
+    adc_input = 0;
+    adc_rr_mask = 0;
+    adc_conversions = 0;
+    __atomic_store_n(&now_ns, 0, __ATOMIC_SEQ_CST);
+    memset(eeprom, 0, sizeof(eeprom));
+}
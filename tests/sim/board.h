@@ -0,0 +1,48 @@
+/* board.h - simulated scan hardware for the host tests
+ *
+ * Three ADG732s share A0-A4 and WR; a WR rising edge latches the address
+ * into every mux whose CS is low, and each output then settles from the
+ * previous address's level towards the new one with the input's RC time
+ * constant. The ADC converts in 2 us, with round-robin over inputs 0..2
+ * (GP26..GP28) and the temperature sensor on input 4. A shared nanosecond
+ * clock advances on every timer read, GPIO write and conversion, so the
+ * firmware's busy-waits and timestamps behave as on the board.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Settled level of every mux input, 10-bit counts (what a perfect ADC reads)
+extern uint16_t sim_level[3][32];
+// Settling time constant of every input after an address change, ns (0 = instant)
+extern uint32_t sim_tau_ns[3][32];
+// Peak-to-peak white noise added to each conversion, 12-bit counts
+extern uint16_t sim_noise_12bit;
+// Optional ADC transfer error: ideal 12-bit code in, converted code out
+extern uint16_t (*sim_adc_transfer)(uint16_t code);
+// Raw 12-bit reading of the internal temperature sensor
+extern uint16_t sim_temp_raw;
+// When set, the USB frame number register follows the clock (1 ms frames)
+extern bool sim_usb_sof;
+
+// Cost of the operations that move the clock
+#define SIM_TIMER_READ_NS 100
+#define SIM_GPIO_WRITE_NS 20
+#define SIM_ADC_CONVERSION_NS 2000
+
+// Rest every input at `level`, no settling, no noise, clock at zero, core1
+// stopped; the EEPROM datablock is erased
+void sim_reset(uint16_t level);
+
+uint64_t sim_time_ns(void);
+void sim_advance_ns(uint64_t ns);
+
+// Conversions done since sim_reset()
+uint32_t sim_adc_conversions(void);
+// Address currently latched in mux m
+uint8_t sim_latched_address(uint8_t m);
+
+// core1 stand-in (sim/core1_sim.c): the entry passed to core1_launch() runs
+// on a thread; this stops it at its next park point and joins it
+void sim_core1_stop(void);
@@ -0,0 +1,73 @@
+/* core1_sim.c - core1.h on a host thread
+ *
+ * Same launch and park contract as core1.c: the entry runs on its own
+ * thread, park requests are honoured at core1_park_point(). sim_core1_stop()
+ * ends the thread at its next park point so a test can launch again.
+ */
+#include "core1.h"
+#include "board.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+static pthread_t core1_thread;
+static bool core1_started = false;
+static volatile bool park_requested = false;
+static volatile bool parked = false;
+static volatile bool stop_requested = false;
+static uint8_t park_depth = 0;
+
+static void *core1_thread_main(void *arg) {
+    ((void (*)(void))arg)();
+    return NULL;
+}
+
+void core1_launch(void (*entry)(void)) {
+    if (core1_started || !entry) return;
+    stop_requested = false;
+    core1_started = true;
+    pthread_create(&core1_thread, NULL, core1_thread_main, (void *)entry);
+}
+
+bool core1_running(void) {
+    return core1_started;
+}
+
+void core1_park_point(void) {
+    if (__atomic_load_n(&stop_requested, __ATOMIC_SEQ_CST)) {
+        pthread_exit(NULL);
+    }
+    if (__atomic_load_n(&park_requested, __ATOMIC_SEQ_CST)) {
+        __atomic_store_n(&parked, true, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&park_requested, __ATOMIC_SEQ_CST)) {
+            sched_yield();
+        }
+        __atomic_store_n(&parked, false, __ATOMIC_SEQ_CST);
+    }
+}
+
+void core1_park_begin(void) {
+    if (!core1_started || park_depth++) return;
+    __atomic_store_n(&park_requested, true, __ATOMIC_SEQ_CST);
+    while (!__atomic_load_n(&parked, __ATOMIC_SEQ_CST)) {
+        sched_yield();
+    }
+}
+
+void core1_park_end(void) {
+    if (!core1_started || !park_depth || --park_depth) return;
+    __atomic_store_n(&park_requested, false, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&parked, __ATOMIC_SEQ_CST)) {
+        sched_yield();
+    }
+}
+
+void sim_core1_stop(void) {
+    if (!core1_started) return;
+    __atomic_store_n(&stop_requested, true, __ATOMIC_SEQ_CST);
+    pthread_join(core1_thread, NULL);
+    core1_started = false;
+    park_requested = false;
+    parked = false;
+    park_depth = 0;
+}
@@ -0,0 +1,4 @@
+#pragma once
+// Keyboard datablock, kept in RAM by sim/board.c
+void eeconfig_read_kb_datablock(void *data);
+void eeconfig_update_kb_datablock(const void *data);
@@ -0,0 +1,15 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+// Simulated RP2040 ADC (sim/board.c): inputs 0..2 are the mux outputs,
+// input 4 is the temperature sensor; results are 12-bit
+void adc_init(void);
+void adc_gpio_init(unsigned gpio);
+void adc_select_input(unsigned input);
+void adc_set_round_robin(unsigned mask);
+uint16_t adc_read(void);
+void adc_set_temp_sensor_enabled(bool enable);
+void adc_run(bool run);
+void adc_set_clkdiv(float div);
+void adc_fifo_setup(bool en, bool dreq_en, uint16_t dreq_thresh, bool err_in_fifo, bool byte_shift);
+void adc_fifo_drain(void);
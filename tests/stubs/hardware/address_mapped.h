@@ -0,0 +1,6 @@
+#pragma once
+#include <stdint.h>
+typedef volatile uint32_t io_rw_32;
+typedef const volatile uint32_t io_ro_32;
+static inline void hw_set_bits(io_rw_32 *a, uint32_t m) { *a |= m; }
+static inline void hw_clear_bits(io_rw_32 *a, uint32_t m) { *a &= ~m; }
@@ -0,0 +1,7 @@
+#pragma once
+#include <stdint.h>
+// Register blocks the scanner reads directly live in host memory
+extern uint32_t sim_usbctrl_regs[4];
+extern uint32_t sim_ppb_regs[0x4000];
+#define USBCTRL_REGS_BASE ((uintptr_t)sim_usbctrl_regs)
+#define PPB_BASE ((uintptr_t)sim_ppb_regs)
@@ -0,0 +1,3 @@
+#pragma once
+#define M0PLUS_SCR_SEVONPEND_BITS 0x10u
+#define M0PLUS_NVIC_ICPR_OFFSET 0xe280u
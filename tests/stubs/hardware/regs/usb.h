@@ -0,0 +1,3 @@
+#pragma once
+#define USB_SOF_RD_OFFSET 0x00000008
+#define USB_SOF_RD_BITS 0x000007ff
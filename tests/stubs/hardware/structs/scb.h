@@ -0,0 +1,4 @@
+#pragma once
+#include <stdint.h>
+typedef struct { volatile uint32_t cpuid, icsr, vtor, aircr, scr; } scb_hw_t;
+extern scb_hw_t *scb_hw;
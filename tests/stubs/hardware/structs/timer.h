@@ -0,0 +1,6 @@
+#pragma once
+#include <stdint.h>
+typedef struct {
+    volatile uint32_t timehw, timelw, timehr, timelr, alarm[4], armed, timerawh, timerawl, dbgpause, pause, intr, inte, intf, ints;
+} timer_hw_t;
+extern timer_hw_t *timer_hw;
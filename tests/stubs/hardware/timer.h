@@ -0,0 +1,7 @@
+#pragma once
+#include <stdint.h>
+#include "hardware/structs/timer.h"
+// Simulated microsecond timer (sim/board.c); every read moves it on a
+// little so busy-wait loops terminate
+uint32_t time_us_32(void);
+uint64_t time_us_64(void);
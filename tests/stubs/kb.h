@@ -0,0 +1,2 @@
+#pragma once
+#define QMK_KEYBOARD_H "quantum.h"
@@ -0,0 +1,2 @@
+#pragma once
+#define __not_in_flash_func(f) f
@@ -0,0 +1,62 @@
+/* quantum.h - host stand-in for the QMK core headers mux_adc.c uses */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define MATRIX_ROWS 6
+#define MATRIX_COLS 15
+typedef uint16_t matrix_row_t;
+typedef uint32_t pin_t;
+
+#define GP0 0
+#define GP1 1
+#define GP2 2
+#define GP3 3
+#define GP4 4
+#define GP5 5
+#define GP6 6
+#define GP10 10
+#define GP11 11
+#define GP12 12
+#define GP13 13
+#define GP14 14
+#define GP15 15
+#define GP18 18
+#define GP19 19
+#define GP20 20
+#define GP21 21
+#define GP22 22
+#define GP23 23
+#define GP25 25
+#define GP26 26
+#define GP27 27
+#define GP28 28
+#define PROGMEM
+
+// GPIO and ADC are simulated (sim/board.c)
+void writePin(pin_t pin, uint8_t level);
+void writePinLow(pin_t pin);
+void writePinHigh(pin_t pin);
+void setPinOutput(pin_t pin);
+void setPinInput(pin_t pin);
+uint8_t readPin(pin_t pin);
+uint16_t analogReadPin(pin_t pin);
+
+// ChibiOS time, driven by the simulated clock
+void wait_us(uint32_t us);
+void wait_ms(uint32_t ms);
+uint32_t timer_read32(void);
+uint32_t timer_elapsed32(uint32_t last);
+
+// Keycodes and records (uart_keycodes.h)
+enum { SAFE_RANGE = 0x7e00 };
+typedef struct { uint8_t col, row; } keypos_t;
+typedef struct { keypos_t key; bool pressed; uint16_t time; } keyevent_t;
+typedef struct { keyevent_t event; } keyrecord_t;
+
+void raw_hid_send(uint8_t *data, uint8_t length);
+#define RAW_EPSIZE 32
+
+#include "eeconfig.h"
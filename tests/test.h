@@ -0,0 +1,36 @@
+/* test.h - minimal checks for the host tests
+ *
+ * A test is a plain executable: CHECK* report the failing line and count,
+ * test_result() prints a summary and yields the exit status for ctest.
+ */
+#pragma once
+
+#include <stdio.h>
+
+static int test_checks;
+static int test_failures;
+
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        test_checks++;                                                           \
+        if (!(cond)) {                                                           \
+            test_failures++;                                                     \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        }                                                                        \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                           \
+    do {                                                                         \
+        long long check_a_ = (long long)(a), check_b_ = (long long)(b);          \
+        test_checks++;                                                           \
+        if (check_a_ != check_b_) {                                              \
+            test_failures++;                                                     \
+            fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n",    \
+                    __FILE__, __LINE__, #a, #b, check_a_, check_b_);             \
+        }                                                                        \
+    } while (0)
+
+static inline int test_result(const char *name) {
+    printf("%s: %d checks, %d failed\n", name, test_checks, test_failures);
+    return test_failures ? 1 : 0;
+}
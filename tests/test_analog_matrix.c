@@ -0,0 +1,179 @@
+/* test_analog_matrix.c - analog matrix normalization and snapshots
+ *
+ * 1. Snapshots: nothing reads as published before the first pass; then a
+ *    writer thread publishes frames whose every field carries the pass
+ *    number while readers copy them (whole frame and single keys). No copy
+ *    may mix two passes and the sequence never goes back.
+ * 2. Normalization: travel published by evaluate_frame is 0 at rest, scales
+ *    with the distance from the key's baseline over its bottom-out span,
+ *    saturates at ANALOG_TRAVEL_FULL, ignores the side away from its
+ *    polarity and reads 0 for an invalid sample; through a hall curve it
+ *    is monotonic with the same end points.
+ * 3. Polarity: a rising key's hall curve mirrors a falling one's about
+ *    quiescent, and its percent-band trigger points come from the upper
+ *    band (a count narrower than the lower one here).
+ */
+#include "scan_test.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#define PUBLISHES 100000
+
+static volatile bool writer_done;
+
+static void *frame_writer(void *arg) {
+    for (uint32_t pass = 1; pass <= PUBLISHES; pass++) {
+        analog_frame_t *f = analog_matrix_back_buffer();
+        f->time_us = pass;
+        for (uint8_t r = 0; r < MATRIX_ROWS; r++) f->pressed[r] = (matrix_row_t)(pass ^ r);
+        for (uint16_t k = 0; k < ANALOG_MATRIX_KEYS; k++) f->travel[k] = (uint16_t)(pass + k);
+        analog_matrix_publish();
+    }
+    __atomic_store_n(&writer_done, true, __ATOMIC_SEQ_CST);
+    return NULL;
+}
+
+static void test_snapshots(void) {
+    static analog_frame_t f;
+    pthread_t writer;
+    uint32_t reads = 0, torn = 0, backwards = 0, last = 0, single_bad = 0;
+
+    CHECK(!analog_matrix_read(&f));
+    CHECK_EQ(analog_matrix_seq(), 0);
+
+    pthread_create(&writer, NULL, frame_writer, NULL);
+    while (!__atomic_load_n(&writer_done, __ATOMIC_SEQ_CST)) {
+        uint32_t seen = analog_matrix_seq();
+        if (!analog_matrix_read(&f)) continue;
+        bool ok = f.time_us == f.seq;
+        for (uint8_t r = 0; r < MATRIX_ROWS; r++) ok &= f.pressed[r] == (matrix_row_t)(f.seq ^ r);
+        for (uint16_t k = 0; k < ANALOG_MATRIX_KEYS; k++) ok &= f.travel[k] == (uint16_t)(f.seq + k);
+        torn += !ok;
+        backwards += f.seq < last || f.seq < seen;
+        last = f.seq;
+        reads++;
+
+        // A single key comes from this pass or one the writer got to since
+        uint16_t t = analog_matrix_travel(1, 2);
+        uint32_t ahead = (uint16_t)(t - (uint16_t)(f.seq + MATRIX_COLS + 2));
+        single_bad += ahead > analog_matrix_seq() + 2 - f.seq;
+    }
+    pthread_join(writer, NULL);
+
+    printf("analog_matrix: %u reads during %u publishes\n", (unsigned)reads, PUBLISHES);
+    CHECK(reads > 0);
+    CHECK_EQ(torn, 0);
+    CHECK_EQ(backwards, 0);
+    CHECK_EQ(single_bad, 0);
+    CHECK(analog_matrix_read(&f));
+    CHECK_EQ(f.seq, PUBLISHES);
+    CHECK_EQ(analog_matrix_seq(), PUBLISHES);
+    CHECK_EQ(analog_matrix_travel(MATRIX_ROWS, 0), 0);
+}
+
+#define CHECK_NEAR(a, b) CHECK(abs((int)(a) - (int)(b)) <= 1)  // Q16 scale rounding
+
+static uint16_t published_travel(uint8_t key_idx, uint16_t level) {
+    static analog_frame_t f;
+    replay_pass(key_idx, level);
+    analog_matrix_read(&f);
+    return f.travel[key_idx];
+}
+
+static void test_normalization(void) {
+    const uint16_t span = 200;
+    uint8_t key = scan_plan[7].key_idx;
+    uint32_t off = 0;
+
+    sim_reset(512);
+    scan_boot();
+    uint16_t base = key_baseline[key];
+
+    // Linear curve: travel = distance * FULL / span
+    key_bottom_out[key] = span;
+    key_polarity[key] = 0;
+    travel_lut_linear(&key_lut[key]);
+    update_key_band(key);
+    CHECK_EQ(published_travel(key, base), 0);
+    for (uint16_t d = 0; d <= span; d++) {
+        int32_t want = (int32_t)d * ANALOG_TRAVEL_FULL / span;
+        int32_t got = published_travel(key, (uint16_t)(base - d));
+        off += got < want - 1 || got > want + 1;
+    }
+    CHECK_EQ(off, 0);
+    CHECK_EQ(published_travel(key, (uint16_t)(base - span)), ANALOG_TRAVEL_FULL);
+    CHECK_EQ(published_travel(key, (uint16_t)(base - span - 50)), ANALOG_TRAVEL_FULL);
+    CHECK_EQ(published_travel(key, 4095), 0);
+
+    // Unknown polarity reads either side; a known one only its own
+    CHECK_NEAR(published_travel(key, (uint16_t)(base + span / 2)), ANALOG_TRAVEL_FULL / 2);
+    key_polarity[key] = -1;
+    update_key_band(key);
+    CHECK_EQ(published_travel(key, (uint16_t)(base + span / 2)), 0);
+    CHECK_NEAR(published_travel(key, (uint16_t)(base - span / 2)), ANALOG_TRAVEL_FULL / 2);
+    key_polarity[key] = 1;
+    update_key_band(key);
+    CHECK_EQ(published_travel(key, (uint16_t)(base - span / 2)), 0);
+    CHECK_NEAR(published_travel(key, (uint16_t)(base + span / 2)), ANALOG_TRAVEL_FULL / 2);
+
+    // Hall curve: same end points, never going back
+    key_polarity[key] = -1;
+    travel_lut_build(&key_lut[key], base, span, key_polarity[key]);
+    update_key_band(key);
+    uint16_t last = 0;
+    uint32_t backwards = 0;
+    for (uint16_t d = 0; d <= span; d++) {
+        uint16_t t = published_travel(key, (uint16_t)(base - d));
+        backwards += t < last;
+        last = t;
+    }
+    CHECK_EQ(backwards, 0);
+    CHECK_EQ(published_travel(key, base), 0);
+    CHECK_EQ(last, ANALOG_TRAVEL_FULL);
+}
+
+static void test_polarity(void) {
+    travel_lut_t falling, rising, towards, fallback;
+    uint8_t key = scan_plan[9].key_idx;
+
+    travel_lut_build(&falling, HALL_QUIESCENT - 112, 300, -1);
+    travel_lut_build(&rising, HALL_QUIESCENT + 112, 300, 1);
+    CHECK(memcmp(&falling, &rising, sizeof(falling)) == 0);
+    // Pressing towards quiescent does not fit the model: configured gap
+    travel_lut_build(&towards, HALL_QUIESCENT - 112, 300, 1);
+    travel_lut_build(&fallback, HALL_QUIESCENT, 300, 0);
+    CHECK(memcmp(&towards, &fallback, sizeof(towards)) == 0);
+    CHECK(memcmp(&towards, &falling, sizeof(towards)) != 0);
+
+    // Base 515 at 10 %: band edges 52 counts down, 51 up
+    sim_reset(512);
+    scan_boot();
+    key_baseline[key] = 515;
+    key_bottom_out[key] = 200;
+    key_sensitivity_percent[key] = 10;
+    key_actuation_mm_x100[key] = 0;
+    travel_lut_linear(&key_lut[key]);
+    const key_band_t *b = &key_band[key];
+    for (int8_t polarity = -1; polarity <= 1; polarity++) {
+        key_polarity[key] = polarity;
+        update_key_band(key);
+        uint16_t edge = (polarity < 0) ? 515 - b->press_lo : b->press_hi - 515;
+        CHECK_EQ(edge, (polarity < 0) ? 52 : 51);
+        CHECK_EQ(b->press_depth, key_depth(key, b, edge + 1));
+        CHECK(b->release_depth < b->press_depth);
+        // The key presses one count past the band on its own side
+        key_pressed[key] = false;
+        int sign = (polarity < 0) ? -1 : 1;
+        CHECK(!replay_pass(key, (uint16_t)(515 + sign * (int)edge)));
+        CHECK(replay_pass(key, (uint16_t)(515 + sign * (int)(edge + 1))));
+        replay_pass(key, 515);
+    }
+}
+
+int main(void) {
+    test_snapshots();
+    test_normalization();
+    test_polarity();
+    return test_result("analog_matrix");
+}
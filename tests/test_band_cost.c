@@ -0,0 +1,100 @@
+/* test_band_cost.c - per-sample cost of the press decision
+ *
+ * Before the cached bands, evaluate_frame derived each key's percent band
+ * from its baseline on every sample (two 32-bit multiply/divides); now it
+ * compares against key_band. The old derivation is kept here as the
+ * reference: both must decide every sample the same way, and the benchmark
+ * prints ns per sample for the old derivation, the cached compare and the
+ * whole of evaluate_frame. Timings are printed, not checked (host noise).
+ */
+#include "scan_test.h"
+
+#include <time.h>
+
+#define BENCH_SAMPLES 4000000u
+#define BENCH_FRAMES 20000u
+
+static volatile uint32_t sink;
+
+// evaluate_frame's press decision before the cached bands
+static bool legacy_should_press(uint8_t key_idx, uint16_t adc_val) {
+    uint16_t base = key_baseline[key_idx] ? key_baseline[key_idx] : 512;
+    uint8_t sens = key_sensitivity_percent[key_idx] ? key_sensitivity_percent[key_idx] : 10;
+    uint32_t lower = ((uint32_t)base * (100 - sens)) / 100;
+    uint32_t upper = ((uint32_t)base * (100 + sens)) / 100;
+    if (lower < 1) lower = 1;
+    if (upper > 4095) upper = 4095;
+    return (adc_val < lower) || (adc_val > upper);
+}
+
+static inline bool cached_should_press(uint8_t key_idx, uint16_t adc_val) {
+    const key_band_t *b = &key_band[key_idx];
+    return (adc_val < b->press_lo) || (adc_val > b->press_hi);
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Calibrated keys with spread baselines and sensitivities
+static void setup_keys(void) {
+    calibration_complete = true;
+    for (uint8_t k = 0; k < MAX_KEYS; k++) {
+        key_baseline[k] = (uint16_t)(380 + (k * 37) % 300);
+        key_sensitivity_percent[k] = (uint8_t)(1 + k % 40);
+        key_sensitivity_sigma[k] = 0;
+        update_key_band(k);
+    }
+}
+
+static void test_same_decisions(void) {
+    uint32_t mismatched = 0;
+
+    for (uint8_t k = 0; k < MAX_KEYS; k++) {
+        for (uint16_t v = 0; v < 1024; v++) {
+            mismatched += legacy_should_press(k, v) != cached_should_press(k, v);
+        }
+    }
+    CHECK_EQ(mismatched, 0);
+}
+
+static void bench(void) {
+    static uint16_t values[1024];
+    static uint16_t frame[MAX_KEYS];
+    matrix_row_t matrix[MATRIX_ROWS];
+    uint32_t acc = 0;
+
+    for (uint16_t i = 0; i < 1024; i++) values[i] = (uint16_t)((i * 613u) % 1024);
+
+    double t0 = now_ns();
+    for (uint32_t n = 0; n < BENCH_SAMPLES; n++) {
+        acc += legacy_should_press((uint8_t)(n % MAX_KEYS), values[n & 1023]);
+    }
+    double t1 = now_ns();
+    for (uint32_t n = 0; n < BENCH_SAMPLES; n++) {
+        acc += cached_should_press((uint8_t)(n % MAX_KEYS), values[n & 1023]);
+    }
+    double t2 = now_ns();
+    for (uint32_t f = 0; f < BENCH_FRAMES; f++) {
+        for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+            frame[scan_plan[i].key_idx] = values[(f + i * 7) & 1023];
+        }
+        acc += evaluate_frame(matrix, frame);
+    }
+    double t3 = now_ns();
+    sink = acc;
+
+    printf("band_cost: derive per sample %.2f ns, cached compare %.2f ns, evaluate_frame %.2f ns per key\n",
+           (t1 - t0) / BENCH_SAMPLES, (t2 - t1) / BENCH_SAMPLES, (t3 - t2) / ((double)BENCH_FRAMES * SCAN_PLAN_LEN));
+}
+
+int main(void) {
+    sim_reset(512);
+    matrix_init_custom();
+    setup_keys();
+    test_same_decisions();
+    bench();
+    return test_result("band_cost");
+}
@@ -0,0 +1,123 @@
+/* test_core_handoff.c - core0/core1 handoff under load (pthreads)
+ *
+ * 1. Seqlock: a writer thread publishes snapshots whose every field carries
+ *    the pass number while the reader copies them as fast as it can; no copy
+ *    may mix two passes and sequence numbers never go back.
+ * 2. Config changes: the real scanner runs on its own thread while core0
+ *    hammers the per-key setters. Every change must land between passes
+ *    (no snapshot published while it is made), the scanner must keep going,
+ *    and the bands it ends up with must be those the last settings give.
+ *    Holds nest (an EEPROM write parks core1 itself): the inner release
+ *    must not let the scanner go.
+ */
+#include "scan_test.h"
+
+#include <pthread.h>
+
+#define PUBLISHES 200000
+
+static volatile bool writer_done;
+
+static void *snapshot_writer(void *arg) {
+    static uint16_t frame[MAX_KEYS];
+    static matrix_row_t matrix[MATRIX_ROWS];
+
+    for (uint32_t pass = 1; pass <= PUBLISHES; pass++) {
+        for (uint8_t k = 0; k < MAX_KEYS; k++) frame[k] = (uint16_t)pass;
+        for (uint8_t r = 0; r < MATRIX_ROWS; r++) matrix[r] = (matrix_row_t)(pass ^ r);
+        snapshot_publish(matrix, frame);
+    }
+    __atomic_store_n(&writer_done, true, __ATOMIC_SEQ_CST);
+    return NULL;
+}
+
+static void test_seqlock(void) {
+    static uint16_t frame[MAX_KEYS];
+    matrix_row_t matrix[MATRIX_ROWS];
+    pthread_t writer;
+    uint32_t last_seq = 0, reads = 0, torn = 0, backwards = 0;
+
+    pthread_create(&writer, NULL, snapshot_writer, NULL);
+    while (!__atomic_load_n(&writer_done, __ATOMIC_SEQ_CST)) {
+        uint32_t seq = snapshot_read(matrix, frame);
+        if (!seq) continue;  // nothing published yet
+        bool ok = true;
+        for (uint8_t k = 1; k < MAX_KEYS; k++) ok &= frame[k] == frame[0];
+        for (uint8_t r = 0; r < MATRIX_ROWS; r++) ok &= matrix[r] == (matrix_row_t)(frame[0] ^ r);
+        ok &= (seq & 1) == 0 && frame[0] == (uint16_t)(seq / 2);
+        torn += !ok;
+        backwards += seq < last_seq;
+        last_seq = seq;
+        reads++;
+    }
+    pthread_join(writer, NULL);
+
+    printf("seqlock: %u reads during %u publishes\n", (unsigned)reads, PUBLISHES);
+    CHECK_EQ(torn, 0);
+    CHECK_EQ(backwards, 0);
+    CHECK(reads > 0);
+    CHECK_EQ(snapshot_read(matrix, frame), 2u * PUBLISHES);
+}
+
+static void test_config_handoff(void) {
+    enum { ROUNDS = 300 };
+    matrix_row_t matrix[MATRIX_ROWS] = {0};
+    uint32_t published_during = 0;
+
+    sim_reset(512);
+    memset(&scan_snapshot, 0, sizeof(scan_snapshot));
+    scan_boot();
+    CHECK(core1_running());
+
+    // Keys moving while the settings change under them
+    for (uint16_t round = 0; round < ROUNDS; round++) {
+        const scan_plan_entry_t *e = &scan_plan[round % SCAN_PLAN_LEN];
+        sim_key_level(e->key_idx, (round & 1) ? 512 : 330);
+
+        uint32_t before = scan_snapshot.seq;
+        scanner_hold();
+        uint32_t held = scan_snapshot.seq;
+        sim_advance_ns(200000);  // a pass worth of time: nothing may publish
+        published_during += scan_snapshot.seq != held;
+        scanner_hold();  // nested, as an EEPROM write inside a held section
+        scanner_release();
+        sim_advance_ns(200000);
+        published_during += scan_snapshot.seq != held;
+        scanner_release();
+        CHECK((held & 1) == 0);
+        CHECK(held >= before);
+
+        // Concurrent with the running scanner
+        set_key_threshold(e->key_idx, (uint8_t)(2 + round % 20));
+        set_key_sensitivity_sigma(e->key_idx, (uint8_t)(round % 7));
+        set_key_actuation(e->key_idx, (uint16_t)((round % 3) ? 100 + round % 250 : 0), 0);
+        set_key_rapid_trigger(e->key_idx, (uint8_t)(round % 3), (uint8_t)(10 + round % 40), (uint8_t)(10 + round % 30));
+        matrix_scan_custom(matrix);
+    }
+    CHECK_EQ(published_during, 0);
+
+    // The scanner is still alive after all the parking
+    uint32_t seq = scan_snapshot.seq;
+    snapshot_wait_frame(adc_frame);
+    CHECK(scan_snapshot.seq > seq);
+
+    // With core1 parked, every band must be what its final settings give
+    scanner_hold();
+    uint32_t mismatched = 0;
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        uint8_t key_idx = scan_plan[i].key_idx;
+        key_band_t live = key_band[key_idx];
+        update_key_band(key_idx);
+        mismatched += memcmp(&live, &key_band[key_idx], sizeof(live)) != 0;
+    }
+    scanner_release();
+    CHECK_EQ(mismatched, 0);
+
+    sim_core1_stop();
+}
+
+int main(void) {
+    test_seqlock();
+    test_config_handoff();
+    return test_result("core_handoff");
+}
@@ -0,0 +1,116 @@
+/* test_dnl.c - ADC DNL correction against a synthetic error model
+ *
+ * The model converter spreads 4096 + 4 x ADC_DNL_EXTRA_LSB fine steps over
+ * the input range, with the codes 512, 1536, 2560 and 3584 each covering
+ * ADC_DNL_EXTRA_LSB + 1 of them, as on the RP2040. Checked:
+ *  1. every code: the corrected reading is within one code of the input,
+ *     or within half a wide code on the wide ones;
+ *  2. through the scan and calibration, with a little noise as dither: the
+ *     mean reading and the calibrated baseline sit on the input level
+ *     across the range keys rest in.
+ * Built with and without ADC_DNL_CORRECTION; the uncorrected build reports
+ * the error the model leaves, so the comparison shows what the table buys.
+ * Built for the serial scan as well, which reads analogReadPin's 10-bit
+ * results: 3. every key reads exactly that, with no correction applied.
+ */
+#include "scan_test.h"
+
+#include <stdlib.h>
+
+#define E ADC_DNL_EXTRA_LSB
+#define PASSES 64
+
+static uint16_t dnl_model(uint16_t code) {
+    uint32_t fine = ((uint32_t)code * (4096 + 4 * E) + 2048) / 4096;
+    uint32_t raw = fine;
+    for (uint32_t k = 0; k < 4; k++) {
+        uint32_t wide = 512 + 1024 * k;  // raw code
+        uint32_t start = wide + k * E;   // first fine step it covers
+        if (fine > start + E) {
+            raw = fine - (k + 1) * E;
+        } else if (fine >= start) {
+            raw = wide;
+            break;
+        }
+    }
+    return (uint16_t)((raw > 4095) ? 4095 : raw);
+}
+
+static void test_codes(void) {
+    uint32_t worst = 0, worst_wide = 0;
+    for (uint16_t code = 0; code < 4096; code++) {
+        uint16_t raw = dnl_model(code);
+        uint32_t err = (uint32_t)abs((int)adc_correct_dnl(raw) - (int)code);
+        if ((raw & 1023) == 512) {
+            if (err > worst_wide) worst_wide = err;
+        } else if (err > worst) {
+            worst = err;
+        }
+    }
+    printf("dnl (correction %d): worst code error %u, on the wide codes %u\n", ADC_DNL_CORRECTION, (unsigned)worst,
+           (unsigned)worst_wide);
+#if ADC_DNL_CORRECTION
+    CHECK(worst <= 1);
+    CHECK(worst_wide <= E / 2 + 1);
+#else
+    CHECK(worst >= E / 2);  // the model bites
+#endif
+}
+
+static void test_levels(void) {
+    uint8_t key = scan_plan[12].key_idx;
+    double worst_mean = 0;
+    uint32_t worst_base = 0;
+
+    for (uint16_t level = 300; level <= 720; level += 15) {
+        sim_reset(level);
+        sim_adc_transfer = dnl_model;
+        sim_noise_12bit = 6;
+        scan_boot();
+        uint32_t base_err = (uint32_t)abs((int)key_baseline[key] - (int)level);
+        if (base_err > worst_base) worst_base = base_err;
+
+        uint32_t sum = 0;
+        for (uint8_t p = 0; p < PASSES; p++) {
+            scan_mux_frame(adc_frame);
+            sum += adc_frame[key];
+        }
+        double err = (double)sum / PASSES - level;
+        if (err < 0) err = -err;
+        if (err > worst_mean) worst_mean = err;
+    }
+    printf("dnl (correction %d): worst mean reading error %.2f counts, worst baseline error %u counts\n",
+           ADC_DNL_CORRECTION, worst_mean, (unsigned)worst_base);
+#if ADC_DNL_CORRECTION
+    CHECK(worst_mean <= 0.5);
+    CHECK(worst_base <= 1);
+#else
+    CHECK(worst_mean >= 1.0);
+#endif
+}
+
+#if !MUX_SCAN_PARALLEL
+static void test_serial(void) {
+    uint32_t off = 0;
+    for (uint16_t level = 300; level <= 720; level += 15) {
+        sim_reset(level);
+        sim_adc_transfer = dnl_model;
+        scan_boot();
+        scan_mux_frame(adc_frame);
+        uint16_t want = dnl_model((uint16_t)(level * 4 + 2)) >> 2;
+        for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) off += adc_frame[scan_plan[i].key_idx] != want;
+    }
+    printf("dnl (serial): %u readings off analogReadPin\n", (unsigned)off);
+    CHECK_EQ(off, 0);
+}
+#endif
+
+int main(void) {
+    test_codes();
+#if MUX_SCAN_PARALLEL
+    test_levels();
+#else
+    test_serial();
+#endif
+    return test_result("dnl");
+}
@@ -0,0 +1,156 @@
+/* test_drift.c - baseline drift tracking over slowly drifting traces
+ *
+ * Built inline (MUX_SCAN_CORE1=0) and with the core1 scanner:
+ *  inline: every resting input drifts 24 counts down over a few thousand
+ *     passes, then back up past where it started. No key may press, each
+ *     baseline must follow its input and stay within BASELINE_DRIFT_MAX of
+ *     calibration, and a real press must still register afterwards; a key
+ *     held down meanwhile keeps its baseline.
+ *  core1: the scanner tracks drift on its thread while core0 recalibrates
+ *     over and over (sampled by matrix_scan_custom, as from raw HID). After each recalibration the new baselines, their
+ *     calibrated values, the drift accumulators and the bands must agree.
+ */
+#include "scan_test.h"
+
+#include <sched.h>
+
+#define DRIFT_COUNTS 24
+#define PASSES_PER_COUNT 120
+
+static void set_all(uint16_t level) {
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) sim_key_level(scan_plan[i].key_idx, level);
+}
+
+#if !MUX_SCAN_CORE1
+static uint32_t pressed_passes;
+
+static void pass(matrix_row_t matrix[]) {
+    scan_mux_frame(adc_frame);
+    evaluate_frame(matrix, adc_frame);
+}
+
+// Enough passes for a step to get through the spike filter
+static void settle(matrix_row_t matrix[]) {
+    for (uint8_t p = 0; p < 3; p++) pass(matrix);
+}
+
+static uint32_t drift_to(uint16_t from, uint16_t to, uint8_t held) {
+    matrix_row_t matrix[MATRIX_ROWS];
+    int step = (to > from) ? 1 : -1;
+    uint32_t bad = 0;
+
+    for (uint16_t level = from; level != to; level = (uint16_t)(level + step)) {
+        for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+            if (scan_plan[i].key_idx != held) sim_key_level(scan_plan[i].key_idx, (uint16_t)(level + step));
+        }
+        for (uint16_t p = 0; p < PASSES_PER_COUNT; p++) {
+            pass(matrix);
+            for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+                uint8_t key_idx = scan_plan[i].key_idx;
+                if (key_idx != held) pressed_passes += matrix_key(matrix, key_idx);
+                int32_t off = (int32_t)key_baseline[key_idx] - key_baseline_cal[key_idx];
+                bad += off > BASELINE_DRIFT_MAX || off < -BASELINE_DRIFT_MAX;
+            }
+        }
+    }
+    return bad;
+}
+
+static void test_follow(void) {
+    matrix_row_t matrix[MATRIX_ROWS];
+    uint8_t held = scan_plan[5].key_idx;
+    uint8_t probe = scan_plan[20].key_idx;
+    uint32_t out_of_range = 0;
+
+    sim_reset(512);
+    scan_boot();
+    uint16_t held_base = key_baseline[held];
+    sim_key_level(held, 300);
+    settle(matrix);
+    CHECK(matrix_key(matrix, held));
+
+    out_of_range += drift_to(512, 512 - DRIFT_COUNTS, held);
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        uint8_t key_idx = scan_plan[i].key_idx;
+        if (key_idx == held) continue;
+        int32_t lag = (int32_t)key_baseline[key_idx] - (512 - DRIFT_COUNTS);
+        CHECK(lag >= -1 && lag <= 2);
+    }
+    out_of_range += drift_to(512 - DRIFT_COUNTS, 512 + DRIFT_COUNTS / 2, held);
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        uint8_t key_idx = scan_plan[i].key_idx;
+        if (key_idx == held) continue;
+        int32_t lag = (int32_t)key_baseline[key_idx] - (512 + DRIFT_COUNTS / 2);
+        CHECK(lag >= -2 && lag <= 1);
+    }
+    printf("drift: %u pressed passes, %u out of range\n", (unsigned)pressed_passes, (unsigned)out_of_range);
+    CHECK_EQ(pressed_passes, 0);
+    CHECK_EQ(out_of_range, 0);
+    CHECK_EQ(key_baseline[held], held_base);
+    settle(matrix);
+    CHECK(matrix_key(matrix, held));
+
+    // A press on the drifted baseline still registers and releases
+    sim_key_level(probe, 512 + DRIFT_COUNTS / 2 - 120);
+    settle(matrix);
+    CHECK(matrix_key(matrix, probe));
+    sim_key_level(probe, 512 + DRIFT_COUNTS / 2);
+    settle(matrix);
+    CHECK(!matrix_key(matrix, probe));
+}
+#else
+static void test_recalibrate_under_drift(void) {
+    enum { ROUNDS = 16 };
+    uint32_t mismatched = 0, off_cal = 0, off_acc = 0, off_level = 0;
+
+    sim_reset(512);
+    scan_boot();
+    CHECK(core1_running());
+
+    for (uint16_t round = 0; round < ROUNDS; round++) {
+        // The board keeps drifting a count at a time, the recalibration
+        // measuring across the step
+        uint16_t level = (uint16_t)(500 + round);
+        set_all(level);
+        recalibrate_sensors();
+        while (mux_recalibrating()) {
+            matrix_row_t matrix[MATRIX_ROWS];
+            matrix_scan_custom(matrix);
+            sched_yield();  // the scanner's thread may share the CPU
+        }
+
+        scanner_hold();
+        for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+            uint8_t key_idx = scan_plan[i].key_idx;
+            key_band_t live = key_band[key_idx];
+            update_key_band(key_idx);
+            mismatched += memcmp(&live, &key_band[key_idx], sizeof(live)) != 0;
+
+            int32_t off = (int32_t)key_baseline[key_idx] - key_baseline_cal[key_idx];
+            off_cal += off > 1 || off < -1;  // at most a step since the recalibration
+            int32_t acc = (int32_t)(key_baseline_acc[key_idx] >> BASELINE_DRIFT_SHIFT) - key_baseline_cal[key_idx];
+            off_acc += acc > 2 || acc < -2;
+            int32_t meas = (int32_t)key_baseline_cal[key_idx] - level;
+            off_level += meas > 1 || meas < -2;
+        }
+        scanner_release();
+    }
+    printf("drift: %u rounds of recalibration under drift tracking\n", (unsigned)ROUNDS);
+    CHECK_EQ(mismatched, 0);
+    CHECK_EQ(off_cal, 0);
+    CHECK_EQ(off_acc, 0);
+    CHECK_EQ(off_level, 0);
+
+    sim_core1_stop();
+}
+#endif
+
+int main(void) {
+#if MUX_SCAN_CORE1
+    test_recalibrate_under_drift();
+    return test_result("drift (core1)");
+#else
+    test_follow();
+    return test_result("drift (inline)");
+#endif
+}
@@ -0,0 +1,150 @@
+/* test_hysteresis.c - band hysteresis against the old debounce timer
+ *
+ * Synthetic per-pass ADC traces for one key are replayed through
+ * evaluate_frame (one pass every PASS_US) and through a model of the code
+ * it replaced: a single press/release point and a state change allowed
+ * only once DEBOUNCE_MS had elapsed on the millisecond timer since the
+ * last one. Checked:
+ *  1. fast taps: every press and release lands on the sample that crosses,
+ *     where the timer delayed or swallowed the ones following a recent
+ *     change;
+ *  2. a key hovering at its press point with noise: one press and no
+ *     chatter, where the single point toggled with the noise.
+ */
+#include "scan_test.h"
+
+#define PASS_US 250
+#define DEBOUNCE_MS 2  // what the timer was set to
+#define TRACE_LEN 4000
+
+static uint8_t key;
+static uint16_t base;
+static uint16_t press_counts, release_counts;  // deviation that presses / releases
+static uint32_t pass_no;
+
+typedef struct {
+    uint32_t changes;
+    uint32_t latency_passes;      // summed over the trace's crossings
+    uint32_t max_latency_passes;
+    uint32_t missed;              // crossings never reported before the next one
+} replay_t;
+
+static void setup(void) {
+    sim_reset(512);
+    scan_boot();
+    key = scan_plan[SCAN_PLAN_LEN / 2].key_idx;
+    key_rt[key].mode = RAPID_TRIGGER_OFF;
+    base = key_band[key].base;
+
+    // Smallest deviations the firmware presses at and stays pressed at
+    const key_band_t *b = &key_band[key];
+    for (press_counts = 1; key_depth(key, b, press_counts) < b->press_depth; press_counts++) {
+    }
+    for (release_counts = 1; key_depth(key, b, release_counts) < b->release_depth; release_counts++) {
+    }
+    CHECK(release_counts < press_counts);
+}
+
+// The replaced logic: one point both ways, changes gated by the ms timer
+static bool legacy_pass(uint16_t level, bool *pressed, uint32_t *last_ms) {
+    uint32_t now_ms = pass_no * PASS_US / 1000;
+    bool should_press = level <= base - press_counts;
+    if (should_press != *pressed && now_ms - *last_ms > DEBOUNCE_MS) {
+        *pressed = should_press;
+        *last_ms = now_ms;
+    }
+    return *pressed;
+}
+
+// Replay a trace through both; latency counts passes from the first sample
+// past the firmware's press (or release) point to the reported change
+static void replay(const uint16_t *trace, uint32_t len, replay_t *fw, replay_t *legacy) {
+    bool fw_state = false, legacy_state = false, legacy_prev = false, want = false;
+    uint32_t legacy_ms = 0;
+    uint32_t crossed = 0;
+    bool fw_seen = true, legacy_seen = true;
+
+    memset(fw, 0, sizeof(*fw));
+    memset(legacy, 0, sizeof(*legacy));
+    for (uint32_t n = 0; n < len; n++, pass_no++) {
+        uint16_t dev = (trace[n] < base) ? base - trace[n] : 0;
+        bool next = want ? dev >= release_counts : dev >= press_counts;
+        if (next != want) {
+            fw->missed += !fw_seen;
+            legacy->missed += !legacy_seen;
+            want = next;
+            crossed = n;
+            fw_seen = legacy_seen = false;
+        }
+
+        sim_advance_ns(PASS_US * 1000u);
+        bool f = replay_pass(key, trace[n]);
+        bool l = legacy_pass(trace[n], &legacy_state, &legacy_ms);
+        fw->changes += f != fw_state;
+        legacy->changes += l != legacy_prev;
+        fw_state = f;
+        legacy_prev = l;
+
+        if (!fw_seen && f == want) {
+            fw_seen = true;
+            fw->latency_passes += n - crossed;
+            if (n - crossed > fw->max_latency_passes) fw->max_latency_passes = n - crossed;
+        }
+        if (!legacy_seen && l == want) {
+            legacy_seen = true;
+            legacy->latency_passes += n - crossed;
+            if (n - crossed > legacy->max_latency_passes) legacy->max_latency_passes = n - crossed;
+        }
+    }
+}
+
+static void test_fast_taps(void) {
+    static uint16_t trace[TRACE_LEN];
+    replay_t fw, legacy;
+    uint32_t taps = 0;
+
+    // 1 ms down, 1.5 ms up: bottom-out taps at 400 per second
+    for (uint32_t n = 0; n < TRACE_LEN; n++) {
+        uint32_t phase = n % 10;
+        trace[n] = (phase < 4) ? base - ANALOG_BOTTOM_OUT_DEFAULT / 2 - 40 : base;
+        taps += phase == 0;
+    }
+    replay(trace, TRACE_LEN, &fw, &legacy);
+    printf("hysteresis taps: firmware %u changes, %u missed, latency %u passes (max %u); "
+           "timer %u changes, %u missed, latency %u passes (max %u)\n",
+           (unsigned)fw.changes, (unsigned)fw.missed, (unsigned)fw.latency_passes, (unsigned)fw.max_latency_passes,
+           (unsigned)legacy.changes, (unsigned)legacy.missed, (unsigned)legacy.latency_passes,
+           (unsigned)legacy.max_latency_passes);
+    CHECK_EQ(fw.changes, 2 * taps);
+    CHECK_EQ(fw.missed, 0);
+    CHECK_EQ(fw.max_latency_passes, 0);
+    CHECK(legacy.missed > 0);
+    CHECK(legacy.max_latency_passes > 0);
+}
+
+static void test_hover_noise(void) {
+    static uint16_t trace[TRACE_LEN];
+    replay_t fw, legacy;
+    uint32_t noise = 0x2545f491u;
+
+    // Ramp in to the press point, then hover on it with +-(gap / 3) noise
+    uint16_t gap = (uint16_t)(press_counts - release_counts);
+    for (uint32_t n = 0; n < TRACE_LEN; n++) {
+        noise ^= noise << 13;
+        noise ^= noise >> 17;
+        noise ^= noise << 5;
+        int32_t dev = (n < 20) ? (int32_t)(press_counts * n / 20) : press_counts + (int32_t)(noise % (2 * gap / 3 + 1)) - gap / 3;
+        trace[n] = (uint16_t)(base - dev);
+    }
+    replay(trace, TRACE_LEN, &fw, &legacy);
+    printf("hysteresis hover: firmware %u changes, timer %u changes\n", (unsigned)fw.changes, (unsigned)legacy.changes);
+    CHECK_EQ(fw.changes, 1);
+    CHECK(legacy.changes > 1);
+}
+
+int main(void) {
+    setup();
+    test_fast_taps();
+    test_hover_noise();
+    return test_result("hysteresis");
+}
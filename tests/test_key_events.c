@@ -0,0 +1,171 @@
+/* test_key_events.c - key event ring under concurrent load, and the
+ * overflow resync in matrix_scan_custom
+ *
+ * 1. Ring: a producer thread pushes numbered events as fast as it can
+ *    (yielding when the queue is full) while the consumer drains them. Every event comes out whole, in order and at
+ *    most once; the ones missing are exactly those whose push failed, and
+ *    the overflow flag says so. A second run flushes now and then: nothing
+ *    flushed may come back.
+ * 2. Resync: with the scanner parked, the test plays core1. It overflows
+ *    the queue, lets core0 flush, then commits a tap in the pass still in
+ *    progress (after the flush, before that pass's snapshot) and a press in
+ *    the pass after. core0 must take the matrix from the snapshot without
+ *    replaying the tap, and still deliver the later press.
+ * 3. Recalibration: requested as over raw HID, it is sampled between
+ *    matrix_scan_custom calls. Taps made meanwhile all come through, with
+ *    no overflow, and it finishes after CALIBRATION_SAMPLES intervals.
+ */
+#include "scan_test.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#define EVENTS 1000000u
+
+static volatile bool producer_done;
+static uint32_t failed_pushes;
+
+static void *producer(void *arg) {
+    failed_pushes = 0;
+    for (uint32_t n = 1; n <= EVENTS; n++) {
+        if (!key_events_push(n, n * 3, (uint8_t)(n % MAX_KEYS), n & 1)) {
+            failed_pushes++;
+            sched_yield();  // full: let the consumer catch up
+        }
+    }
+    __atomic_store_n(&producer_done, true, __ATOMIC_SEQ_CST);
+    return NULL;
+}
+
+static void run_ring(bool flushing) {
+    pthread_t thread;
+    uint32_t received = 0, torn = 0, backwards = 0, last = 0;
+
+    key_events_flush();
+    producer_done = false;
+    pthread_create(&thread, NULL, producer, NULL);
+    for (;;) {
+        bool done = __atomic_load_n(&producer_done, __ATOMIC_SEQ_CST);
+        const key_event_t *ev = key_events_peek();
+        if (!ev) {
+            if (done) break;
+            sched_yield();
+            continue;
+        }
+        uint32_t n = (uint32_t)ev->time_us;
+        torn += ev->seq != n * 3 || ev->key_idx != n % MAX_KEYS || ev->pressed != (n & 1);
+        backwards += n <= last;
+        last = n;
+        key_events_drop();
+        received++;
+        if (flushing && received % 1000 == 0) key_events_flush();
+    }
+    pthread_join(thread, NULL);
+
+    printf("key_events: %s%u received, %u pushes failed\n", flushing ? "flushing, " : "", (unsigned)received,
+           (unsigned)failed_pushes);
+    CHECK_EQ(torn, 0);
+    CHECK_EQ(backwards, 0);
+    if (!flushing) {
+        CHECK_EQ(received + failed_pushes, EVENTS);
+        CHECK_EQ(key_events_overflowed(), failed_pushes > 0);
+    }
+    key_events_flush();
+    CHECK(!key_events_overflowed());
+    CHECK(key_events_peek() == NULL);
+}
+
+static void test_resync(void) {
+    static matrix_row_t snap[MATRIX_ROWS];
+    static uint16_t frame[MAX_KEYS];
+    matrix_row_t current[MATRIX_ROWS] = {0};
+    uint8_t flood = scan_plan[3].key_idx, tap = scan_plan[10].key_idx, later = scan_plan[20].key_idx;
+    uint32_t tap_changes = 0;
+
+    sim_reset(512);
+    scan_boot();
+    CHECK(core1_running());
+    for (uint8_t n = 0; n < 4; n++) matrix_scan_custom(current);
+    CHECK(key_events_peek() == NULL);
+
+    scanner_hold();
+    uint32_t s = snapshot_read(snap, frame);
+
+    // The pass in progress (publishing s + 2) floods the queue
+    for (uint32_t n = 0; n <= KEY_EVENT_QUEUE_LEN; n++) key_events_push(n, s + 2, flood, !(n & 1));
+    CHECK(key_events_overflowed());
+    matrix_scan_custom(current);  // flush, wait for the snapshot after s
+
+    // Same pass, after the flush: a tap, then the pass publishes
+    key_events_push(1000, s + 2, tap, true);
+    key_events_push(1001, s + 2, tap, false);
+    snap[flood / MATRIX_COLS] |= (matrix_row_t)1 << (flood % MATRIX_COLS);
+    snapshot_publish(snap, frame);
+
+    // The next pass commits a press before core0 looks
+    key_events_push(2000, s + 4, later, true);
+
+    for (uint8_t n = 0; n < 4; n++) {
+        bool before = matrix_key(current, tap);
+        matrix_scan_custom(current);
+        tap_changes += matrix_key(current, tap) != before;
+    }
+    CHECK_EQ(tap_changes, 0);
+    CHECK(matrix_key(current, flood));
+    CHECK(matrix_key(current, later));
+    CHECK(key_events_peek() == NULL);
+
+    scanner_release();
+    sim_core1_stop();
+}
+
+// Hold the key at `level` until core0's matrix shows `pressed`; false if
+// that takes more than a few passes' worth of calls
+static bool tap_edge(matrix_row_t current[], uint8_t key, uint16_t level, bool pressed) {
+    sim_key_level(key, level);
+    for (uint32_t n = 0; n < 100000; n++) {
+        matrix_scan_custom(current);
+        if (matrix_key(current, key) == pressed) return true;
+        sched_yield();
+    }
+    return false;
+}
+
+static void test_recalibration(void) {
+    matrix_row_t current[MATRIX_ROWS] = {0};
+    uint8_t key = scan_plan[7].key_idx;
+    uint32_t taps = 0, lost = 0, overflowed = 0;
+
+    sim_reset(512);
+    scan_boot();
+    CHECK(core1_running());
+
+    uint32_t start_ms = timer_read32();
+    recalibrate_sensors();
+    while (mux_recalibrating()) {
+        bool down = tap_edge(current, key, 300, true);
+        bool up = tap_edge(current, key, 512, false);
+        if (!mux_recalibrating()) {
+            break;  // finished mid-tap: the new baseline took the press in
+        }
+        lost += !down + !up;
+        overflowed += key_events_overflowed();
+        taps++;
+    }
+    uint32_t took_ms = timer_read32() - start_ms;
+    printf("key_events: %u taps during a %u ms recalibration\n", (unsigned)taps, (unsigned)took_ms);
+    CHECK(taps >= CALIBRATION_SAMPLES / 2);
+    CHECK_EQ(lost, 0);
+    CHECK_EQ(overflowed, 0);
+    CHECK(took_ms >= CALIBRATION_SAMPLES * CALIBRATION_SAMPLE_MS);
+
+    sim_core1_stop();
+}
+
+int main(void) {
+    run_ring(false);
+    run_ring(true);
+    test_resync();
+    test_recalibration();
+    return test_result("key_events");
+}
@@ -0,0 +1,227 @@
+/* test_pio_alignment.c - timing model of the PIO/DMA scan engine
+ *
+ * Pure C, mux_pio.h only. The PIO timeline follows build_program(): per
+ * address mov pins (1 cycle), WR low (8), the settle wait, then three
+ * mov + push [delay] token slots of MUX_PIO_CONV_CYCLES each and the jmp;
+ * one set x per pass. A token reaches the ADC a little after the trig DMA
+ * count drops; the ADC starts it only if idle, converts and the sample DMA
+ * collects the result shortly after. Checked:
+ *  1. sample i of a pass is mux MUX_PIO_SAMPLE_MUX(i), address
+ *     MUX_PIO_SAMPLE_ADDRESS(i);
+ *  2. the token spacing never loses a start, even with a slow ADC, while
+ *     one cycle less does;
+ *  3. the firmware's alignment check (mux_pio_streams_aligned behind the
+ *     MUX_PIO_CHECK_WAIT_NS read sequence) never fires on an aligned run,
+ *     whenever it samples, and always fires once a start was lost;
+ *  4. a restart after a detected loss gives a correctly mapped pass.
+ */
+#include "test.h"
+#include "mux_pio.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define CYCLE_NS (1000000000u / MUX_PIO_CLK_HZ)
+#define DMA_READ_NS 10    // token leaves the RX FIFO: trig count drops
+#define DMA_WRITE_NS 40   // ... and lands in ADC CS
+#define ADC_START_NS 21   // one ADC clock before sampling starts
+#define COLLECT_NS 10     // result waits in the ADC FIFO this long
+#define PASSES 4
+#define TOKENS (PASSES * MUX_PIO_SAMPLES)
+#define NO_DROP (-1)
+
+typedef struct {
+    uint64_t issued[TOKENS];     // trig count drops
+    uint64_t seen[TOKENS];       // ADC sees the start
+    uint64_t done[TOKENS];       // conversion complete (result in FIFO)
+    uint64_t collected[TOKENS];  // sample count drops
+    bool accepted[TOKENS];
+    uint8_t address[TOKENS];
+    uint8_t input[TOKENS];       // round-robin input that converted it
+    // Result slots in collection order: the token each one came from
+    int16_t slot_token[TOKENS];
+    uint16_t results;
+} run_t;
+
+// One engine run from a fresh start at t0. conv_ns is the ADC conversion
+// time; drop_token is a start the ADC ignores on top of busy rejections.
+static void run_engine(run_t *r, uint64_t t0, uint32_t conv_cycles, uint32_t conv_ns, int drop_token) {
+    const uint32_t settle = (uint32_t)MUX_PIO_SETTLE_US * (MUX_PIO_CLK_HZ / 1000000);
+    uint64_t cycle = 0, busy_until = 0;
+    uint8_t rr = 0;  // engine_start selects input 0
+    int k = 0;
+
+    memset(r, 0, sizeof(*r));
+    for (int pass = 0; pass < PASSES; pass++) {
+        cycle += 1;  // set x, 31
+        for (int address = 31; address >= 0; address--) {
+            cycle += 1 + 8 + settle;  // mov pins, WR pulse, settle
+            for (int j = 0; j < 3; j++, k++) {
+                uint64_t push = t0 + (cycle + 1) * CYCLE_NS;  // mov isr, osr then push
+                r->address[k] = (uint8_t)address;
+                r->issued[k] = push + DMA_READ_NS;
+                r->seen[k] = push + DMA_WRITE_NS;
+                r->accepted[k] = r->seen[k] >= busy_until && k != drop_token;
+                if (r->accepted[k]) {
+                    r->input[k] = rr;
+                    rr = (uint8_t)((rr + 1) % 3);
+                    r->done[k] = r->seen[k] + ADC_START_NS + conv_ns;
+                    r->collected[k] = r->done[k] + COLLECT_NS;
+                    busy_until = r->done[k];
+                    r->slot_token[r->results++] = (int16_t)k;
+                }
+                cycle += conv_cycles;
+            }
+            cycle += 1;  // jmp x--
+        }
+    }
+}
+
+static uint32_t count_before(const uint64_t *t, const bool *only, uint64_t now) {
+    uint32_t n = 0;
+    for (int k = 0; k < TOKENS; k++) {
+        n += (!only || only[k]) && t[k] <= now;
+    }
+    return n;
+}
+
+static uint32_t trig_left(const run_t *r, uint64_t t) {
+    return MUX_PIO_SAMPLES - count_before(r->issued, NULL, t) % MUX_PIO_SAMPLES;
+}
+
+static uint32_t sample_left(const run_t *r, uint64_t t) {
+    return MUX_PIO_SAMPLES - count_before(r->collected, r->accepted, t) % MUX_PIO_SAMPLES;
+}
+
+static bool adc_busy(const run_t *r, uint64_t t) {
+    for (int k = 0; k < TOKENS; k++) {
+        if (r->accepted[k] && r->seen[k] <= t && t < r->done[k]) return true;
+    }
+    return false;
+}
+
+static uint32_t fifo_level(const run_t *r, uint64_t t) {
+    uint32_t n = 0;
+    for (int k = 0; k < TOKENS; k++) {
+        n += r->accepted[k] && r->done[k] <= t && t < r->collected[k];
+    }
+    return n;
+}
+
+// streams_in_step() at time t: counts, wait, ADC state, re-read and retry
+static bool check_at(const run_t *r, uint64_t t) {
+    for (;;) {
+        uint32_t trig = trig_left(r, t), sample = sample_left(r, t);
+        t += MUX_PIO_CHECK_WAIT_NS;
+        bool busy = adc_busy(r, t);
+        uint32_t in_adc = fifo_level(r, t + 5) + busy;
+        t += 10;
+        if (busy == adc_busy(r, t) && trig == trig_left(r, t + 5) && sample == sample_left(r, t + 10)) {
+            return mux_pio_streams_aligned(trig, sample, in_adc);
+        }
+        t += 15;
+    }
+}
+
+static uint32_t lost_starts(const run_t *r) {
+    uint32_t n = 0;
+    for (int k = 0; k < TOKENS; k++) n += !r->accepted[k];
+    return n;
+}
+
+// Every result slot of pass p holds its own mux and address
+static bool pass_mapped(const run_t *r, int p) {
+    for (int i = 0; i < MUX_PIO_SAMPLES; i++) {
+        int slot = p * MUX_PIO_SAMPLES + i;
+        if (slot >= r->results) return false;
+        int k = r->slot_token[slot];
+        if (r->input[k] != MUX_PIO_SAMPLE_MUX(i) || r->address[k] != MUX_PIO_SAMPLE_ADDRESS(i)) return false;
+    }
+    return true;
+}
+
+static void test_mapping(void) {
+    static run_t r;
+    bool seen[3][32] = {{false}};
+
+    for (int i = 0; i < MUX_PIO_SAMPLES; i++) {
+        CHECK(!seen[MUX_PIO_SAMPLE_MUX(i)][MUX_PIO_SAMPLE_ADDRESS(i)]);
+        seen[MUX_PIO_SAMPLE_MUX(i)][MUX_PIO_SAMPLE_ADDRESS(i)] = true;
+    }
+    run_engine(&r, 0, MUX_PIO_CONV_CYCLES, 2000, NO_DROP);
+    for (int p = 0; p < PASSES; p++) CHECK(pass_mapped(&r, p));
+}
+
+static void test_spacing(void) {
+    static run_t r;
+
+    // Nominal 48 MHz ADC clock, then 2% slow
+    run_engine(&r, 0, MUX_PIO_CONV_CYCLES, 2000, NO_DROP);
+    CHECK_EQ(lost_starts(&r), 0);
+    run_engine(&r, 0, MUX_PIO_CONV_CYCLES, 2040, NO_DROP);
+    CHECK_EQ(lost_starts(&r), 0);
+    CHECK(pass_mapped(&r, PASSES - 1));
+
+    // One cycle tighter and the ADC is still busy when starts arrive
+    run_engine(&r, 0, MUX_PIO_CONV_CYCLES - 1, 2000, NO_DROP);
+    CHECK(lost_starts(&r) > 0);
+    CHECK(!pass_mapped(&r, PASSES - 1));
+}
+
+static void test_detector(void) {
+    static run_t r;
+    uint32_t checks = 0, false_alarms = 0, missed = 0;
+
+    // Aligned: sample the check all over the run, odd step so it lands on
+    // every phase of the token/conversion cycle
+    run_engine(&r, 0, MUX_PIO_CONV_CYCLES, 2000, NO_DROP);
+    uint64_t end = r.collected[TOKENS - 1];
+    for (uint64_t t = 0; t + 1000 < end; t += 37) {
+        false_alarms += !check_at(&r, t);
+        checks++;
+    }
+    printf("pio_alignment: %u checks on an aligned run\n", (unsigned)checks);
+    CHECK_EQ(false_alarms, 0);
+
+    // One start ignored in the second pass: every check after it fires
+    const int drop = MUX_PIO_SAMPLES + 40;
+    run_engine(&r, 0, MUX_PIO_CONV_CYCLES, 2000, drop);
+    CHECK_EQ(lost_starts(&r), 1);
+    for (uint64_t t = 0; t + 1000 < end; t += 37) {
+        bool aligned = check_at(&r, t);
+        // A check that straddles the drop may retry past it and fire: either is fine
+        if (t + MUX_PIO_CHECK_WAIT_NS + 100 < r.issued[drop]) {
+            false_alarms += !aligned;
+        } else if (t > r.seen[drop]) {
+            missed += aligned;
+        }
+    }
+    CHECK_EQ(false_alarms, 0);
+    CHECK_EQ(missed, 0);
+}
+
+static void test_restart(void) {
+    static run_t r, after;
+
+    // mux_pio_read_frame: copy at the buffer flip, then check
+    const int drop = MUX_PIO_SAMPLES + 40;
+    run_engine(&r, 0, MUX_PIO_CONV_CYCLES, 2000, drop);
+    CHECK(pass_mapped(&r, 0));
+    CHECK(check_at(&r, r.collected[r.slot_token[MUX_PIO_SAMPLES - 1]] + 20000));
+    uint64_t flip = r.collected[r.slot_token[2 * MUX_PIO_SAMPLES - 1]];
+    CHECK(!pass_mapped(&r, 1));
+    CHECK(!check_at(&r, flip + 20000));
+
+    // engine_stop/engine_start: fresh streams from address 31 on input 0
+    run_engine(&after, flip + 30000, MUX_PIO_CONV_CYCLES, 2000, NO_DROP);
+    CHECK(pass_mapped(&after, 0));
+    CHECK(check_at(&after, after.collected[after.slot_token[MUX_PIO_SAMPLES - 1]] + 20000));
+}
+
+int main(void) {
+    test_mapping();
+    test_spacing();
+    test_detector();
+    test_restart();
+    return test_result("pio_alignment");
+}
@@ -0,0 +1,122 @@
+/* test_predictive.c - predictive actuation replay: latency gained against
+ * false actuations
+ *
+ * One key, linear 0.01 mm per count, actuation 1.20 mm / reset 0.80 mm,
+ * static actuation. Presses follow an S-curve (half cosine) down over 3 to
+ * 16 samples and back up. Each lead (PREDICT_LEAD_PERCENT of a sample
+ * interval, set as over raw HID 0x2A) replays:
+ *  - full presses to 3.5 mm: the passes gained over lead 0 on the press;
+ *  - aborted presses peaking at 0.85-1.15 mm, short of actuation: every
+ *    press is a false actuation, and the firmware's own predict_false
+ *    counter must agree.
+ * Lead 0 must match the plain threshold exactly, gains may only grow with
+ * the lead, and a press is never late.
+ */
+#include "scan_test.h"
+
+#include <math.h>
+
+#define ACTUATION_MM_X100 120
+#define RESET_MM_X100 80
+
+static uint8_t key;
+
+static uint16_t level_mm(uint16_t mm_x100) {
+    const key_band_t *b = &key_band[key];
+    uint16_t target = travel_from_mm_x100(mm_x100);
+    uint16_t counts = 0;
+    while (key_depth(key, b, counts) < target) counts++;
+    return (uint16_t)(b->base - counts);
+}
+
+static void rest(void) {
+    for (uint8_t n = 0; n < 16; n++) replay_pass(key, level_mm(0));
+}
+
+// Replay one press to `peak` over `down` samples and back up; returns the
+// sample index of the first press (-1 = never pressed)
+static int press(uint16_t peak, uint8_t down) {
+    int first = -1;
+    uint16_t n = 0;
+    for (uint8_t s = 1; s <= down; s++, n++) {
+        uint16_t mm = (uint16_t)lround(peak * (1 - cos(M_PI * s / down)) / 2);
+        if (replay_pass(key, level_mm(mm)) && first < 0) first = n;
+    }
+    for (uint8_t s = 0; s < 4; s++, n++) {
+        if (replay_pass(key, level_mm(peak)) && first < 0) first = n;
+    }
+    for (uint8_t s = 1; s <= down; s++, n++) {
+        uint16_t mm = (uint16_t)lround(peak * (1 + cos(M_PI * s / down)) / 2);
+        if (replay_pass(key, level_mm(mm)) && first < 0) first = n;
+    }
+    rest();
+    return first;
+}
+
+typedef struct {
+    uint32_t presses, gained_passes, max_gain, late;
+    uint32_t aborted, false_actuations, firmware_false;
+} replay_result_t;
+
+static void replay(uint8_t lead, replay_result_t *r) {
+    memset(r, 0, sizeof(*r));
+    for (uint8_t down = 3; down <= 16; down++) {
+        set_predictive_lead(0);
+        int plain = press(350, down);
+        set_predictive_lead(lead);
+        int predicted = press(350, down);
+        CHECK(plain >= 0 && predicted >= 0);
+        r->presses++;
+        if (predicted > plain) {
+            r->late++;
+        } else {
+            uint32_t gain = (uint32_t)(plain - predicted);
+            r->gained_passes += gain;
+            if (gain > r->max_gain) r->max_gain = gain;
+        }
+    }
+
+    uint32_t false_before = scan_window.predict_false;
+    for (uint8_t down = 3; down <= 16; down++) {
+        for (uint16_t peak = 85; peak <= 115; peak += 5) {
+            r->aborted++;
+            r->false_actuations += press(peak, down) >= 0;
+        }
+    }
+    r->firmware_false = scan_window.predict_false - false_before;
+}
+
+int main(void) {
+    static const uint8_t leads[] = {0, 50, 100, 150, 200};
+    replay_result_t r, prev = {0};
+
+    sim_reset(512);
+    scan_boot();
+    key = scan_plan[SCAN_PLAN_LEN / 5].key_idx;
+    key_bottom_out[key] = KEY_TRAVEL_MM_X100;
+    travel_lut_linear(&key_lut[key]);
+    set_key_actuation(key, ACTUATION_MM_X100, RESET_MM_X100);
+    key_rt[key].mode = RAPID_TRIGGER_OFF;
+    rest();
+
+    for (uint8_t i = 0; i < sizeof(leads); i++) {
+        replay(leads[i], &r);
+        printf("predictive: lead %3u%%: %u presses gained %u passes (max %u), %u late; "
+               "%u/%u aborted presses actuated (firmware counted %u)\n",
+               leads[i], (unsigned)r.presses, (unsigned)r.gained_passes, (unsigned)r.max_gain, (unsigned)r.late,
+               (unsigned)r.false_actuations, (unsigned)r.aborted, (unsigned)r.firmware_false);
+        CHECK_EQ(r.late, 0);
+        CHECK_EQ(r.false_actuations, r.firmware_false);
+        CHECK(r.gained_passes >= prev.gained_passes);
+        CHECK(r.false_actuations >= prev.false_actuations);
+        if (leads[i] == 0) {
+            CHECK_EQ(r.gained_passes, 0);
+            CHECK_EQ(r.false_actuations, 0);
+        }
+        if (leads[i] == PREDICT_LEAD_PERCENT) {
+            CHECK(r.gained_passes > 0);
+        }
+        prev = r;
+    }
+    return test_result("predictive");
+}
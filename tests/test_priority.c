@@ -0,0 +1,117 @@
+/* test_priority.c - bounded staleness under the priority scan schedule
+ *
+ * With MUX_SCAN_PRIORITY, hot keys' addresses are scanned every pass and
+ * cold ones SCAN_COLD_SLICE per pass in rotation. Over thousands of passes
+ * (and priority changes made over the raw HID path's setter in between)
+ * every key's staleness, in passes since it was last sampled, is tracked:
+ *  1. hot keys are sampled every pass;
+ *  2. no cold key goes longer than mux_scan_cold_interval() passes, and in
+ *     time no longer than that many of the longest passes seen;
+ *  3. across a priority change, no key goes longer than the intervals
+ *     before and after it added together;
+ *  4. a press on a cold key registers within its interval.
+ */
+#include "scan_test.h"
+
+#define PASSES 2000
+
+static uint32_t since[MAX_KEYS];      // passes since each key was sampled
+static uint64_t sampled_us[MAX_KEYS];
+static uint32_t worst_passes_hot, worst_passes_cold;
+static uint64_t worst_age_us, longest_pass_us;  // longest over the whole test
+
+static bool is_hot(uint8_t key_idx) {
+    return key_priority[key_idx] != 0;
+}
+
+static void pass(matrix_row_t matrix[]) {
+    uint64_t start = time_us_64();
+    scan_mux_frame(adc_frame);
+    evaluate_frame(matrix, adc_frame);
+    uint64_t now = time_us_64();
+    if (now - start > longest_pass_us) longest_pass_us = now - start;
+
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        uint8_t key_idx = scan_plan[i].key_idx;
+        if (KEY_SAMPLED(key_idx)) {
+            since[key_idx] = 0;
+            sampled_us[key_idx] = key_sample_us[key_idx];
+            continue;
+        }
+        since[key_idx]++;
+        uint32_t *worst = is_hot(key_idx) ? &worst_passes_hot : &worst_passes_cold;
+        if (since[key_idx] > *worst) *worst = since[key_idx];
+        if (now - sampled_us[key_idx] > worst_age_us) worst_age_us = now - sampled_us[key_idx];
+    }
+}
+
+// Run `passes` passes; staleness counts passes a key went unsampled, so an
+// interval of n passes allows n - 1
+static void run(uint32_t passes, uint32_t bound) {
+    matrix_row_t matrix[MATRIX_ROWS];
+    worst_passes_hot = worst_passes_cold = 0;
+    worst_age_us = 0;
+    for (uint32_t p = 0; p < passes; p++) pass(matrix);
+    CHECK_EQ(worst_passes_hot, 0);
+    CHECK(worst_passes_cold + 1 <= bound);
+    CHECK(worst_age_us <= (uint64_t)bound * longest_pass_us);
+}
+
+static void test_steady(void) {
+    uint8_t interval = mux_scan_cold_interval();
+    run(PASSES, interval);
+    printf("priority: cold interval %u passes, worst %u unsampled passes, %u us old (longest pass %u us)\n",
+           interval, (unsigned)worst_passes_cold, (unsigned)worst_age_us, (unsigned)longest_pass_us);
+    CHECK(interval > 1);
+}
+
+static void test_changes(void) {
+    uint8_t before = mux_scan_cold_interval();
+
+    // Everything cold, then everything hot, then the defaults back
+    for (uint8_t k = 0; k < MAX_KEYS; k++) set_key_priority(k, false);
+    uint8_t all_cold = mux_scan_cold_interval();
+    run(PASSES, before + all_cold);
+    run(PASSES, all_cold);
+    for (uint8_t k = 0; k < MAX_KEYS; k++) set_key_priority(k, true);
+    CHECK_EQ(mux_scan_cold_interval(), 1);
+    run(PASSES, all_cold + 1);
+    run(PASSES, 1);
+    static const uint8_t hot_keys[] = {SCAN_HOT_KEYS};
+    for (uint8_t k = 0; k < MAX_KEYS; k++) set_key_priority(k, false);
+    for (uint8_t i = 0; i < sizeof(hot_keys); i++) set_key_priority(hot_keys[i] - 1, true);
+    CHECK_EQ(mux_scan_cold_interval(), before);
+    run(PASSES, 1 + before);
+    run(PASSES, before);
+}
+
+static void test_cold_press(void) {
+    matrix_row_t matrix[MATRIX_ROWS];
+    uint8_t interval = mux_scan_cold_interval();
+    uint32_t worst = 0;
+
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        uint8_t key_idx = scan_plan[i].key_idx;
+        if (is_hot(key_idx)) continue;
+        sim_key_level(key_idx, 300);
+        uint32_t n = 1;
+        for (pass(matrix); !matrix_key(matrix, key_idx) && n < 4 * interval; n++) pass(matrix);
+        if (n > worst) worst = n;
+        sim_key_level(key_idx, 512);
+        for (uint8_t p = 0; p < 2 * interval; p++) pass(matrix);
+    }
+    printf("priority: cold press registers within %u passes\n", (unsigned)worst);
+    CHECK(worst <= interval);
+}
+
+int main(void) {
+    sim_reset(512);
+    scan_boot();
+    // One full rotation first, so every key has a sample taken in a pass
+    matrix_row_t matrix[MATRIX_ROWS];
+    for (uint8_t p = 0; p < mux_scan_cold_interval(); p++) pass(matrix);
+    test_steady();
+    test_changes();
+    test_cold_press();
+    return test_result("priority");
+}
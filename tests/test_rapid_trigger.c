@@ -0,0 +1,162 @@
+/* test_rapid_trigger.c - rapid trigger replay over jitter-tapping traces
+ *
+ * One key, actuation 1.20 mm / reset 0.80 mm, rapid trigger deltas of
+ * 0.18 mm both ways. Traces are written in millimetres and replayed
+ * through evaluate_frame, one pass per sample. Checked:
+ *  1. fast jitter-tapping deep in the travel: every lift past the release
+ *     delta releases and every dip past the press delta re-actuates, on
+ *     the sample that gets there, with no miss between two changes;
+ *  2. jitter smaller than the deltas while held or while lifted: no change;
+ *  3. taps above the actuation point: continuous mode keeps following
+ *     them, plain mode falls back to the fixed points and ignores them;
+ *  4. returning above the reset point releases and disarms in both modes.
+ */
+#include "scan_test.h"
+
+#define DELTA_MM_X100 18  // off the 0.05 mm trace grid, so no sample sits on the edge
+
+static uint8_t key;
+
+// ADC level that reads as `mm_x100` of travel (the first count past it)
+static uint16_t level_mm(uint16_t mm_x100) {
+    const key_band_t *b = &key_band[key];
+    uint16_t target = travel_from_mm_x100(mm_x100);
+    uint16_t counts = 0;
+    while (key_depth(key, b, counts) < target) counts++;
+    return (uint16_t)(b->base - counts);
+}
+
+static bool pass_mm(uint16_t mm_x100) {
+    return replay_pass(key, level_mm(mm_x100));
+}
+
+static void setup(uint8_t mode) {
+    // Linear sensor, 0.01 mm per count, so every step of a trace resolves
+    key_bottom_out[key] = KEY_TRAVEL_MM_X100;
+    travel_lut_linear(&key_lut[key]);
+    set_key_actuation(key, 120, 80);
+    set_key_rapid_trigger(key, mode, DELTA_MM_X100, DELTA_MM_X100);
+    // Start from rest, released and disarmed
+    for (uint8_t n = 0; n < 4; n++) pass_mm(0);
+    CHECK(!key_pressed[key]);
+}
+
+// Triangle between lo and hi in steps of `step`, `cycles` times, starting
+// at hi going up (towards lo). Each state change must land on the first
+// sample DELTA past the last turn.
+static void jitter_tapping(uint16_t lo, uint16_t hi, uint16_t step, uint8_t cycles) {
+    uint32_t releases = 0, presses = 0, late = 0;
+    bool pressed = key_pressed[key];
+    uint16_t turn = hi;
+
+    for (uint8_t c = 0; c < cycles; c++) {
+        for (int32_t mm = hi - step; mm >= lo; mm -= step) {
+            bool now = pass_mm((uint16_t)mm);
+            bool due = turn - mm >= DELTA_MM_X100;
+            late += due != !now;
+            releases += pressed && !now;
+            pressed = now;
+        }
+        turn = lo;
+        for (int32_t mm = lo + step; mm <= hi; mm += step) {
+            bool now = pass_mm((uint16_t)mm);
+            bool due = mm - turn >= DELTA_MM_X100;
+            late += due != now;
+            presses += !pressed && now;
+            pressed = now;
+        }
+        turn = hi;
+    }
+    CHECK_EQ(releases, cycles);
+    CHECK_EQ(presses, cycles);
+    CHECK_EQ(late, 0);
+}
+
+static void test_jitter_tapping(uint8_t mode) {
+    setup(mode);
+    for (uint16_t mm = 0; mm <= 300; mm += 20) pass_mm(mm);
+    CHECK(key_pressed[key]);
+
+    // 0.3 mm taps at 0.05 mm per sample, then a faster 0.25 mm one
+    jitter_tapping(250, 300, 5, 20);
+    jitter_tapping(200, 250, 25, 40);
+    CHECK(key_pressed[key]);
+}
+
+static void test_small_jitter(uint8_t mode) {
+    uint32_t changes = 0;
+    bool pressed;
+
+    setup(mode);
+    for (uint16_t mm = 0; mm <= 250; mm += 25) pass_mm(mm);
+    pressed = key_pressed[key];
+    CHECK(pressed);
+    for (uint16_t n = 0; n < 400; n++) {
+        bool now = pass_mm((uint16_t)(250 - (n % 4) * 5));  // 0.15 mm of wobble
+        changes += now != pressed;
+        pressed = now;
+    }
+    // Lift 0.25 mm and wobble there
+    pass_mm(225);
+    pressed = pass_mm(225 - DELTA_MM_X100 - 5);
+    CHECK(!pressed);
+    for (uint16_t n = 0; n < 400; n++) {
+        bool now = pass_mm((uint16_t)(200 + (n % 4) * 5));
+        changes += now != pressed;
+        pressed = now;
+    }
+    CHECK_EQ(changes, 0);
+}
+
+static void test_shallow_taps(void) {
+    uint32_t continuous = 0, plain = 0;
+
+    // Down past actuation, then tap between 0.85 and 1.15 mm (between the
+    // reset and actuation points)
+    for (uint8_t mode = RAPID_TRIGGER_ON; mode <= RAPID_TRIGGER_CONTINUOUS; mode++) {
+        uint32_t *changes = (mode == RAPID_TRIGGER_CONTINUOUS) ? &continuous : &plain;
+        setup(mode);
+        for (uint16_t mm = 0; mm <= 150; mm += 25) pass_mm(mm);
+        bool pressed = key_pressed[key];
+        for (uint8_t c = 0; c < 10; c++) {
+            for (uint16_t mm = 115; mm >= 85; mm -= 10) {
+                bool now = pass_mm(mm);
+                *changes += now != pressed;
+                pressed = now;
+            }
+            for (uint16_t mm = 95; mm <= 115; mm += 10) {
+                bool now = pass_mm(mm);
+                *changes += now != pressed;
+                pressed = now;
+            }
+        }
+    }
+    CHECK_EQ(continuous, 20);
+    CHECK_EQ(plain, 0);
+}
+
+static void test_full_return(uint8_t mode) {
+    setup(mode);
+    for (uint16_t mm = 0; mm <= 300; mm += 20) pass_mm(mm);
+    CHECK(key_pressed[key]);
+    CHECK(key_rt[key].armed);
+    pass_mm(60);
+    CHECK(!key_pressed[key]);
+    CHECK(!key_rt[key].armed);
+    // Wobble near rest is below actuation: nothing
+    for (uint8_t n = 0; n < 20; n++) CHECK(!pass_mm((uint16_t)(40 + (n & 1) * 40)));
+}
+
+int main(void) {
+    sim_reset(512);
+    scan_boot();
+    key = scan_plan[SCAN_PLAN_LEN / 3].key_idx;
+
+    for (uint8_t mode = RAPID_TRIGGER_ON; mode <= RAPID_TRIGGER_CONTINUOUS; mode++) {
+        test_jitter_tapping(mode);
+        test_small_jitter(mode);
+        test_full_return(mode);
+    }
+    test_shallow_taps();
+    return test_result("rapid_trigger");
+}
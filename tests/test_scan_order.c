@@ -0,0 +1,103 @@
+/* test_scan_order.c - settle time per scan ordering on the RC model
+ *
+ * Every mux input rests at its own level (spread like a populated board)
+ * and settles with the same time constant, so an address's settle time
+ * depends only on the step from the address before it. For each ordering
+ * the simulator finds, per address, the shortest wait after latching it
+ * that reads all three outputs within MUX_SETTLE_TOLERANCE, and reports
+ * the pass total:
+ *  - plan: MUX_WIRING order (init_scan_order);
+ *  - interleaved: addresses sorted by level and alternated low/high, a bad
+ *    case for comparison;
+ *  - optimized: optimize_scan_order.
+ * The optimized order must visit every address once and settle faster
+ * than both.
+ */
+#include "scan_test.h"
+
+#include <stdlib.h>
+
+#define TAU_NS 3000
+
+// Shortest wait (us) after latching `ch` with `prev` settled before it
+static uint32_t settle_us(uint8_t prev, uint8_t ch) {
+    for (uint32_t wait = 0; wait < MUX_SETTLE_US; wait++) {
+        uint16_t sample[3];
+        bool ok = true;
+        select_mux_channel(prev);
+        scan_wait_us(MUX_SETTLE_US);
+        select_mux_channel(ch);
+        scan_wait_us(wait);
+        read_adc_round_robin(sample);
+        for (uint8_t m = 0; m < 3; m++) ok &= abs((int)sample[m] - (int)sim_level[m][ch]) <= MUX_SETTLE_TOLERANCE;
+        if (ok) return wait;
+    }
+    return MUX_SETTLE_US;
+}
+
+// Settle time of one pass over scan_order (passes wrap around)
+static uint32_t pass_settle_us(void) {
+    uint32_t total = 0;
+    mux_cs_select(MUX_CS_ALL);
+    for (uint8_t o = 0; o < scan_order_len; o++) {
+        uint8_t prev = scan_plan[scan_order[o ? o - 1 : scan_order_len - 1]].channel;
+        total += settle_us(prev, scan_plan[scan_order[o]].channel);
+    }
+    mux_cs_release();
+    return total;
+}
+
+static int cmp_level(const void *a, const void *b) {
+    uint16_t la = sim_level[0][scan_plan[*(const uint8_t *)a].channel];
+    uint16_t lb = sim_level[0][scan_plan[*(const uint8_t *)b].channel];
+    return (int)la - (int)lb;
+}
+
+static void interleave_order(void) {
+    uint8_t sorted[32];
+    init_scan_order();
+    memcpy(sorted, scan_order, scan_order_len);
+    qsort(sorted, scan_order_len, 1, cmp_level);
+    for (uint8_t o = 0, lo = 0, hi = scan_order_len - 1; o < scan_order_len; o++) {
+        scan_order[o] = (o & 1) ? sorted[hi--] : sorted[lo++];
+    }
+}
+
+int main(void) {
+    uint32_t seed = 0x9e3779b9u;
+
+    sim_reset(512);
+    for (uint8_t m = 0; m < 3; m++) {
+        for (uint8_t a = 0; a < 32; a++) {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            // Muxes follow each other loosely, as neighbouring switches do
+            sim_level[m][a] = (uint16_t)(300 + (a * 53) % 360 + (seed % 40));
+            sim_tau_ns[m][a] = TAU_NS;
+        }
+    }
+    matrix_init_custom();
+
+    init_scan_order();
+    uint32_t plan = pass_settle_us();
+    interleave_order();
+    uint32_t interleaved = pass_settle_us();
+    optimize_scan_order();
+    uint32_t optimized = pass_settle_us();
+
+    printf("scan_order: settle per pass: plan %u us, interleaved %u us, optimized %u us (%u addresses)\n",
+           (unsigned)plan, (unsigned)interleaved, (unsigned)optimized, (unsigned)scan_order_len);
+
+    // Every address group exactly once
+    uint32_t seen = 0;
+    for (uint8_t o = 0; o < scan_order_len; o++) seen |= 1u << scan_plan[scan_order[o]].channel;
+    init_scan_order();
+    uint32_t want = 0;
+    for (uint8_t o = 0; o < scan_order_len; o++) want |= 1u << scan_plan[scan_order[o]].channel;
+    CHECK_EQ(seen, want);
+
+    CHECK(optimized < plan);
+    CHECK(optimized < interleaved);
+    return test_result("scan_order");
+}
@@ -0,0 +1,87 @@
+/* test_settle.c - adaptive settle budgets against an RC settling model
+ *
+ * Every mux input settles with its own time constant (1.5-5 us) from
+ * resting levels spread over a few hundred counts. The budgets measured at
+ * boot (measure_settle_times) must then read every address within
+ * MUX_SETTLE_TOLERANCE of its level after a full-scale step from the
+ * address scanned before it, both ways, and must still come in well under
+ * the fixed MUX_SETTLE_US per address.
+ */
+#include "scan_test.h"
+
+#include <stdlib.h>
+
+#define LEVEL_LOW 20
+#define LEVEL_HIGH 780   // highest reading filter_adc_sample keeps
+#define LEVEL_FULL 1023
+
+static uint8_t order_pos[32];
+
+static void set_rest_and_tau(void) {
+    for (uint8_t m = 0; m < 3; m++) {
+        for (uint8_t a = 0; a < 32; a++) {
+            sim_level[m][a] = (uint16_t)(380 + ((m * 32 + a) * 37) % 260);
+            sim_tau_ns[m][a] = 1500 + ((m * 7 + a * 13) % 8) * 500;
+        }
+    }
+}
+
+// Alternate addresses along the scan order between `lo` and `hi`; the
+// ones at `check_parity` read `hi`, so they all see a full-scale step
+static void alternate(uint8_t check_parity, uint16_t at_check, uint16_t others) {
+    for (uint8_t m = 0; m < 3; m++) {
+        for (uint8_t a = 0; a < 32; a++) sim_level[m][a] = others;
+    }
+    for (uint8_t o = 0; o < scan_order_len; o++) {
+        uint8_t ch = scan_plan[scan_order[o]].channel;
+        if ((o & 1) == check_parity) {
+            for (uint8_t m = 0; m < 3; m++) sim_level[m][ch] = at_check;
+        }
+    }
+}
+
+// Worst error over the checked addresses, second pass (the first one's
+// first address steps from wherever the boot left the muxes)
+static uint32_t worst_error(uint8_t check_parity, uint16_t at_check) {
+    uint32_t worst = 0;
+    for (uint8_t p = 0; p < 2; p++) scan_cpu_frame(adc_frame);
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        const scan_plan_entry_t *e = &scan_plan[i];
+        // With an odd count the wrap puts two of a parity side by side
+        if ((order_pos[e->channel] & 1) != check_parity || order_pos[e->channel] == 0) continue;
+        uint32_t err = (uint32_t)abs((int)adc_frame[e->key_idx] - (int)at_check);
+        if (err > worst) worst = err;
+    }
+    return worst;
+}
+
+int main(void) {
+    uint32_t total = 0, worst = 0;
+
+    sim_reset(512);
+    set_rest_and_tau();
+    scan_boot();
+    for (uint8_t o = 0; o < scan_order_len; o++) {
+        uint8_t ch = scan_plan[scan_order[o]].channel;
+        order_pos[ch] = o;
+        total += address_settle_us[ch];
+        CHECK(address_settle_us[ch] >= MUX_SETTLE_MIN_US);
+        CHECK(address_settle_us[ch] <= MUX_SETTLE_US);
+    }
+
+    for (uint8_t parity = 0; parity < 2; parity++) {
+        uint32_t e;
+        alternate(parity, LEVEL_LOW, LEVEL_FULL);  // falling full scale
+        e = worst_error(parity, LEVEL_LOW);
+        worst = (e > worst) ? e : worst;
+        alternate(parity, LEVEL_HIGH, 0);  // rising
+        e = worst_error(parity, LEVEL_HIGH);
+        worst = (e > worst) ? e : worst;
+    }
+
+    printf("settle: %u us per pass adaptive, %u us fixed; worst full-scale error %u counts\n",
+           (unsigned)total, (unsigned)(scan_order_len * MUX_SETTLE_US), (unsigned)worst);
+    CHECK(worst <= MUX_SETTLE_TOLERANCE);
+    CHECK(total < scan_order_len * MUX_SETTLE_US / 2);
+    return test_result("settle");
+}
@@ -0,0 +1,101 @@
+/* test_spikes.c - single-pass spikes through the scan, with and without
+ * the median filter (SPIKE_FILTER)
+ *
+ * Spikes are injected on the simulated inputs for exactly one pass and
+ * scanned through scan_mux_frame and evaluate_frame. Checked:
+ *  1. a spike past the crosstalk limit (an invalid 4095) neither presses a
+ *     resting key nor releases a held one, filter or not;
+ *  2. a one-pass dip to full travel: the filter drops every one, without
+ *     it each is a tap;
+ *  3. a real press or release lands one pass later with the filter, on the
+ *     pass itself without it;
+ *  4. calibrating with the rest well off HALL_QUIESCENT leaves the polarity
+ *     unknown, so a press on either side counts until a bottom-out capture
+ *     picks one.
+ */
+#include "scan_test.h"
+
+#define SPIKES 200
+
+static uint8_t key;
+static uint16_t base;
+
+static bool pass(void) {
+    matrix_row_t matrix[MATRIX_ROWS];
+    scan_mux_frame(adc_frame);
+    evaluate_frame(matrix, adc_frame);
+    return matrix_key(matrix, key);
+}
+
+// Passes until the key reads `want` after its input steps to `level`
+static uint32_t step_latency(uint16_t level, bool want) {
+    uint32_t passes = 0;
+    sim_key_level(key, level);
+    while (pass() != want && passes < 8) passes++;
+    return passes;
+}
+
+// One pass at `spike` on top of `level`; counts the passes the key
+// reads other than `state` over the spike and the two after it
+static uint32_t inject(uint16_t level, uint16_t spike, bool state) {
+    uint32_t wrong = 0;
+    sim_key_level(key, spike);
+    wrong += pass() != state;
+    sim_key_level(key, level);
+    for (uint8_t p = 0; p < 2; p++) wrong += pass() != state;
+    return wrong;
+}
+
+static void test_spikes(void) {
+    uint32_t invalid_wrong = 0, dip_wrong = 0;
+    uint16_t held = (uint16_t)(base - ANALOG_BOTTOM_OUT_DEFAULT);
+
+    for (uint32_t n = 0; n < SPIKES; n++) invalid_wrong += inject(base, 1000, false);
+    CHECK_EQ(step_latency(held, true), SPIKE_FILTER);
+    for (uint32_t n = 0; n < SPIKES; n++) invalid_wrong += inject(held, 1000, true);
+    CHECK_EQ(step_latency(base, false), SPIKE_FILTER);
+    for (uint32_t n = 0; n < SPIKES; n++) dip_wrong += inject(base, held, false);
+
+    printf("spikes (filter %d): invalid %u wrong passes, dips %u wrong passes over %u spikes\n",
+           SPIKE_FILTER, (unsigned)invalid_wrong, (unsigned)dip_wrong, SPIKES);
+    CHECK_EQ(invalid_wrong, 0);
+#if SPIKE_FILTER
+    CHECK_EQ(dip_wrong, 0);
+#else
+    CHECK_EQ(dip_wrong, SPIKES);  // pressed on the spike, released next pass
+#endif
+}
+
+static void test_polarity_unknown(void) {
+    const uint16_t rest = HALL_QUIESCENT - 120;
+
+    sim_reset(rest);
+    scan_boot();
+    CHECK_EQ(key_polarity[key], 0);
+    CHECK_EQ(step_latency((uint16_t)(rest + ANALOG_BOTTOM_OUT_DEFAULT), true), SPIKE_FILTER);
+    CHECK_EQ(step_latency(rest, false), SPIKE_FILTER);
+    CHECK_EQ(step_latency((uint16_t)(rest - ANALOG_BOTTOM_OUT_DEFAULT), true), SPIKE_FILTER);
+    CHECK_EQ(step_latency(rest, false), SPIKE_FILTER);
+
+    // Capture a press upwards, against what the rest offset would suggest:
+    // only that side counts from then on
+    capture_bottom_out(true);
+    sim_key_level(key, (uint16_t)(rest + ANALOG_BOTTOM_OUT_DEFAULT));
+    for (uint8_t p = 0; p < 3; p++) pass();
+    sim_key_level(key, rest);
+    for (uint8_t p = 0; p < 3; p++) pass();
+    capture_bottom_out(false);
+    CHECK_EQ(key_polarity[key], 1);
+    sim_key_level(key, (uint16_t)(rest - ANALOG_BOTTOM_OUT_DEFAULT));
+    for (uint8_t p = 0; p < 3; p++) CHECK(!pass());
+}
+
+int main(void) {
+    sim_reset(512);
+    scan_boot();
+    key = scan_plan[SCAN_PLAN_LEN / 4].key_idx;
+    base = key_band[key].base;
+    test_spikes();
+    test_polarity_unknown();
+    return test_result("spikes");
+}
@@ -0,0 +1,145 @@
+/* test_temperature.c - temperature compensation with the core1 scanner
+ *
+ * Every key's rest level follows the internal sensor's reading with its own
+ * slope, -2..+2 counts per two sensor counts (about 1.07 counts/degC each).
+ * The scanner runs on core1 and samples the temperature between passes;
+ * core0 plays the host, round after round:
+ *  1. starts a warm-up (raw HID 0x2D), warms the board up a sensor count at
+ *     a time, polling the progress (0x2E) as it goes, and stops;
+ *  2. the learned slopes must match the model, the fit must be reset and
+ *     the bands must agree with update_key_band;
+ *  3. cools the board back down: every baseline must follow its level, the
+ *     temperature offsets must account for the move, and no key may press
+ *     (later rounds catch a drift anchor left behind by an earlier fit).
+ */
+#include "scan_test.h"
+
+#include <math.h>
+#include <sched.h>
+#include <stdlib.h>
+
+#define RAW_COLD 876  // sim_reset()'s sensor reading
+#define RAW_SPAN 22   // about 10 degC
+#define PASSES_PER_STEP 64
+#define ROUNDS 3
+
+static int8_t slope(uint8_t key_idx) {
+    return (int8_t)(key_idx % 5) - 2;
+}
+
+// Levels at a sensor reading; the sensor reads lower as it warms up
+static void set_raw(uint16_t raw) {
+    sim_temp_raw = raw;
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        uint8_t key_idx = scan_plan[i].key_idx;
+        sim_key_level(key_idx, (uint16_t)(512 + slope(key_idx) * (RAW_COLD - (int)raw) / 2));
+    }
+}
+
+static uint32_t pressed;
+
+// Let the scanner run `passes` passes, then take core0's scan
+static void wait_passes(uint16_t passes) {
+    matrix_row_t matrix[MATRIX_ROWS];
+    static uint16_t frame[MAX_KEYS];
+    uint32_t until = snapshot_read(matrix, frame) + 2u * passes;
+    while ((int32_t)(snapshot_read(matrix, frame) - until) < 0) {
+        sched_yield();  // the scanner's thread may share the CPU
+    }
+    matrix_scan_custom(matrix);
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) pressed += matrix[r] != 0;
+}
+
+// Expected slope, Q8 counts/degC: a sensor count is 3.3 V / 4096 over
+// 1.721 mV/degC
+static int32_t expected_q8(uint8_t key_idx) {
+    return (int32_t)lround(slope(key_idx) / 2.0 * 1721.0 * 4096 / 3300000 * 256);
+}
+
+static void warm_up(uint32_t *bad_progress) {
+    mux_temperature_t t;
+    uint16_t last = 0;
+
+    learn_temperature(true);
+    for (uint16_t raw = RAW_COLD; raw >= RAW_COLD - RAW_SPAN; raw--) {
+        set_raw(raw);
+        wait_passes(PASSES_PER_STEP);
+        mux_temperature(&t);
+        *bad_progress += !t.learning || t.learn_samples < last;
+        last = t.learn_samples;
+    }
+    mux_temperature(&t);
+    printf("temperature: warm-up %u samples over %u.%02u degC\n", (unsigned)t.learn_samples,
+           (unsigned)(t.learn_span_x100 / 100), (unsigned)(t.learn_span_x100 % 100));
+    CHECK(t.learn_samples >= TEMP_LEARN_MIN_SAMPLES);
+    CHECK(t.learn_span_x100 >= TEMP_LEARN_MIN_SPAN_X100);
+    learn_temperature(false);
+}
+
+static void check_fit(uint32_t *bad_slope, uint32_t *mismatched) {
+    scanner_hold();
+    CHECK(!temp_learning);
+    CHECK_EQ(temp_fit.n, 0);
+    CHECK_EQ(temp_applied_x100, temp_ref_x100);
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        uint8_t key_idx = scan_plan[i].key_idx;
+        int32_t want = expected_q8(key_idx);
+        *bad_slope += abs(key_temp_coef_q8[key_idx] - want) > 48;
+        CHECK_EQ(key_temp_offset[key_idx], 0);
+
+        key_band_t live = key_band[key_idx];
+        update_key_band(key_idx);
+        *mismatched += memcmp(&live, &key_band[key_idx], sizeof(live)) != 0;
+    }
+    scanner_release();
+}
+
+static void cool_down(uint32_t *off_level, uint32_t *off_offset, uint32_t *mismatched) {
+    for (uint16_t raw = RAW_COLD - RAW_SPAN; raw <= RAW_COLD; raw++) {
+        set_raw(raw);
+        wait_passes(PASSES_PER_STEP);
+    }
+    wait_passes(4 * PASSES_PER_STEP);
+
+    scanner_hold();
+    for (uint8_t i = 0; i < SCAN_PLAN_LEN; i++) {
+        uint8_t key_idx = scan_plan[i].key_idx;
+        *off_level += abs((int)key_baseline[key_idx] - 512) > 2;
+        // The compensation, not the drift tracker, moved the baseline
+        int32_t moved = slope(key_idx) * RAW_SPAN / 2;
+        *off_offset += abs(key_temp_offset[key_idx] + moved) > 3;
+
+        key_band_t live = key_band[key_idx];
+        update_key_band(key_idx);
+        *mismatched += memcmp(&live, &key_band[key_idx], sizeof(live)) != 0;
+    }
+    scanner_release();
+}
+
+int main(void) {
+    uint32_t bad_progress = 0, bad_slope = 0, off_level = 0, off_offset = 0, mismatched = 0;
+
+    sim_reset(512);
+    scan_boot();
+    CHECK(core1_running());
+    wait_passes(PASSES_PER_STEP);
+
+    for (uint8_t round = 0; round < ROUNDS; round++) {
+        warm_up(&bad_progress);
+        check_fit(&bad_slope, &mismatched);
+        cool_down(&off_level, &off_offset, &mismatched);
+    }
+    printf("temperature: %u rounds; %u bad slopes, %u baselines off their level, %u offsets off, "
+           "%u bands stale, %u pressed scans\n",
+           (unsigned)ROUNDS, (unsigned)bad_slope, (unsigned)off_level, (unsigned)off_offset, (unsigned)mismatched,
+           (unsigned)pressed);
+    CHECK_EQ(bad_progress, 0);
+    CHECK_EQ(bad_slope, 0);
+    CHECK_EQ(off_level, 0);
+    CHECK_EQ(off_offset, 0);
+    CHECK_EQ(mismatched, 0);
+    CHECK_EQ(pressed, 0);
+
+    sim_core1_stop();
+    return test_result("temperature");
+}